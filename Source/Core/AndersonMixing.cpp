@@ -0,0 +1,214 @@
+/* GRTresna
+ * Copyright 2024 The GRTL Collaboration.
+ * Please refer to LICENSE in GRTresna's root directory.
+ */
+
+#include "AndersonMixing.hpp"
+#include "ConstraintVariables.hpp"
+#include "MetricVariables.hpp"
+#include "parstream.H"
+#include <algorithm>
+#include <cmath>
+
+// The solver vars in the multigrid vars must map one to one onto the
+// constraint vars so they can share the vector operations of the solver
+static_assert(c_U_0 - c_psi_reg == c_U - c_psi,
+              "Solver vars must be contiguous in the multigrid vars");
+
+static void clear_vars(Vector<LevelData<FArrayBox> *> &a_vars)
+{
+    for (int ilev = 0; ilev < a_vars.size(); ilev++)
+    {
+        if (a_vars[ilev] != NULL)
+        {
+            delete a_vars[ilev];
+            a_vars[ilev] = NULL;
+        }
+    }
+}
+
+AndersonMixing::~AndersonMixing()
+{
+    clear_vars(m_x_old);
+    clear_vars(m_f_old);
+    clear_vars(m_g_old);
+    for (int i = 0; i < m_delta_f.size(); i++)
+    {
+        clear_vars(m_delta_f[i]);
+        clear_vars(m_delta_g[i]);
+    }
+}
+
+void AndersonMixing::store_previous(
+    const Vector<LevelData<FArrayBox> *> &a_multigrid_vars,
+    const Vector<LevelData<FArrayBox> *> &a_template,
+    MultilevelLinearOp<FArrayBox> &a_op)
+{
+    if (m_x_old.size() == 0)
+    {
+        a_op.create(m_x_old, a_template);
+    }
+    get_solver_vars(m_x_old, a_multigrid_vars);
+}
+
+void AndersonMixing::mix(Vector<LevelData<FArrayBox> *> &a_multigrid_vars,
+                         MultilevelLinearOp<FArrayBox> &a_op)
+{
+    CH_TIME("AndersonMixing::mix");
+    CH_assert(m_x_old.size() > 0);
+
+    // the fixed point map G(x_k) and the residual f_k = G(x_k) - x_k
+    vars_t g, f;
+    a_op.create(g, m_x_old);
+    a_op.create(f, m_x_old);
+    get_solver_vars(g, a_multigrid_vars);
+    a_op.axby(f, g, m_x_old, 1.0, -1.0);
+
+    if (m_has_previous)
+    {
+        vars_t delta_f, delta_g;
+        a_op.create(delta_f, f);
+        a_op.create(delta_g, g);
+        a_op.axby(delta_f, f, m_f_old, 1.0, -1.0);
+        a_op.axby(delta_g, g, m_g_old, 1.0, -1.0);
+        m_delta_f.push_back(delta_f);
+        m_delta_g.push_back(delta_g);
+
+        // only keep the last m_depth differences
+        if (static_cast<int>(m_delta_f.size()) > m_depth)
+        {
+            clear_vars(m_delta_f.front());
+            clear_vars(m_delta_g.front());
+            m_delta_f.pop_front();
+            m_delta_g.pop_front();
+        }
+    }
+    else
+    {
+        a_op.create(m_f_old, f);
+        a_op.create(m_g_old, g);
+        m_has_previous = true;
+    }
+    a_op.assign(m_f_old, f);
+    a_op.assign(m_g_old, g);
+
+    std::vector<Real> gamma;
+    solve_least_squares(gamma, f, a_op);
+
+    // x_{k+1} = x_k + beta f_k - sum_i gamma_i (dG_i - (1 - beta) dF_i)
+    // reuse the storage of g for the new iterate
+    vars_t &x_new = g;
+    a_op.axby(x_new, m_x_old, f, 1.0, m_mixing);
+    for (int i = 0; i < gamma.size(); i++)
+    {
+        a_op.incr(x_new, m_delta_g[i], -gamma[i]);
+        a_op.incr(x_new, m_delta_f[i], gamma[i] * (1.0 - m_mixing));
+    }
+    set_solver_vars(a_multigrid_vars, x_new);
+
+    clear_vars(g);
+    clear_vars(f);
+}
+
+void AndersonMixing::solve_least_squares(std::vector<Real> &a_gamma,
+                                         const vars_t &a_f,
+                                         MultilevelLinearOp<FArrayBox> &a_op)
+{
+    // normal equations (dF^T dF) gamma = dF^T f
+    int n = m_delta_f.size();
+    a_gamma.assign(n, 0.0);
+    if (n == 0)
+    {
+        return;
+    }
+
+    std::vector<std::vector<Real>> A(n, std::vector<Real>(n + 1, 0.0));
+    Real trace = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = i; j < n; j++)
+        {
+            A[i][j] = a_op.dotProduct(m_delta_f[i], m_delta_f[j]);
+            A[j][i] = A[i][j];
+        }
+        A[i][n] = a_op.dotProduct(m_delta_f[i], a_f);
+        trace += A[i][i];
+    }
+
+    // small regularisation as successive differences are often close to
+    // linearly dependent
+    for (int i = 0; i < n; i++)
+    {
+        A[i][i] += 1e-12 * trace;
+    }
+
+    // Gaussian elimination with partial pivoting
+    for (int col = 0; col < n; col++)
+    {
+        int pivot = col;
+        for (int row = col + 1; row < n; row++)
+        {
+            if (std::abs(A[row][col]) > std::abs(A[pivot][col]))
+            {
+                pivot = row;
+            }
+        }
+        if (std::abs(A[pivot][col]) <= 1e-14 * trace)
+        {
+            // singular system - fall back to a plain Picard step
+            pout() << "AndersonMixing: singular least squares system, "
+                      "skipping acceleration for this step"
+                   << endl;
+            a_gamma.assign(n, 0.0);
+            return;
+        }
+        std::swap(A[col], A[pivot]);
+        for (int row = col + 1; row < n; row++)
+        {
+            Real factor = A[row][col] / A[col][col];
+            for (int k = col; k <= n; k++)
+            {
+                A[row][k] -= factor * A[col][k];
+            }
+        }
+    }
+    for (int row = n - 1; row >= 0; row--)
+    {
+        Real sum = A[row][n];
+        for (int k = row + 1; k < n; k++)
+        {
+            sum -= A[row][k] * a_gamma[k];
+        }
+        a_gamma[row] = sum / A[row][row];
+    }
+}
+
+void AndersonMixing::get_solver_vars(vars_t &a_out,
+                                     const vars_t &a_multigrid_vars)
+{
+    for (int ilev = 0; ilev < a_out.size(); ilev++)
+    {
+        DataIterator dit = a_out[ilev]->dataIterator();
+        for (dit.begin(); dit.ok(); ++dit)
+        {
+            (*a_out[ilev])[dit()].copy((*a_multigrid_vars[ilev])[dit()],
+                                       c_psi_reg, c_psi, NUM_CONSTRAINT_VARS);
+        }
+    }
+}
+
+void AndersonMixing::set_solver_vars(vars_t &a_multigrid_vars,
+                                     const vars_t &a_in)
+{
+    for (int ilev = 0; ilev < a_in.size(); ilev++)
+    {
+        DataIterator dit = a_in[ilev]->dataIterator();
+        for (dit.begin(); dit.ok(); ++dit)
+        {
+            // a_in has no ghosts so this only touches the valid cells
+            (*a_multigrid_vars[ilev])[dit()].copy((*a_in[ilev])[dit()], c_psi,
+                                                  c_psi_reg,
+                                                  NUM_CONSTRAINT_VARS);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/* GRTresna
+ * Copyright 2024 The GRTL Collaboration.
+ * Please refer to LICENSE in GRTresna's root directory.
+ */
+
+#ifndef ANDERSONMIXING_HPP_
+#define ANDERSONMIXING_HPP_
+
+#include "FArrayBox.H"
+#include "LevelData.H"
+#include "MultilevelLinearOp.H"
+#include "REAL.H"
+#include "UsingNamespace.H"
+#include <deque>
+
+/// Class which accelerates the outer NL (Picard) iteration using Anderson
+/// mixing on the components of the multigrid vars that are updated by the
+/// linear solver (psi_reg, Vi_0 and U_0). The NL step is treated as a fixed
+/// point map x -> G(x) and the new iterate is built from the last few
+/// iterates by minimising the residual G(x) - x in a least squares sense.
+class AndersonMixing
+{
+  public:
+    AndersonMixing(int a_depth, Real a_mixing)
+        : m_depth(a_depth), m_mixing(a_mixing), m_has_previous(false)
+    {
+    }
+
+    ~AndersonMixing();
+
+    /// store x_k, the solver vars before the linear step is applied
+    void store_previous(const Vector<LevelData<FArrayBox> *> &a_multigrid_vars,
+                        const Vector<LevelData<FArrayBox> *> &a_template,
+                        MultilevelLinearOp<FArrayBox> &a_op);
+
+    /// replace G(x_k), the solver vars after the linear step, with the
+    /// mixed iterate x_{k+1}. Only the valid cells are changed, the ghosts
+    /// need to be refilled afterwards
+    void mix(Vector<LevelData<FArrayBox> *> &a_multigrid_vars,
+             MultilevelLinearOp<FArrayBox> &a_op);
+
+  private:
+    typedef Vector<LevelData<FArrayBox> *> vars_t;
+
+    /// copy the solver components of the multigrid vars into a_out
+    static void get_solver_vars(vars_t &a_out, const vars_t &a_multigrid_vars);
+
+    /// copy a_in into the solver components of the multigrid vars
+    static void set_solver_vars(vars_t &a_multigrid_vars, const vars_t &a_in);
+
+    /// solve the small least squares problem for the mixing coefficients
+    void solve_least_squares(std::vector<Real> &a_gamma, const vars_t &a_f,
+                             MultilevelLinearOp<FArrayBox> &a_op);
+
+    int m_depth;    // max number of previous iterates used
+    Real m_mixing;  // damping of the residual in the update
+    bool m_has_previous;
+
+    vars_t m_x_old; // x_k
+    vars_t m_f_old; // f_{k-1} = G(x_{k-1}) - x_{k-1}
+    vars_t m_g_old; // G(x_{k-1})
+
+    // differences of successive residuals and fixed point maps
+    std::deque<vars_t> m_delta_f;
+    std::deque<vars_t> m_delta_g;
+};
+
+#endif /* ANDERSONMIXING_HPP_ */
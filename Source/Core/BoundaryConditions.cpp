@@ -5,6 +5,7 @@
 
 // Chombo includes
 #include "FArrayBox.H"
+#include "LoHiSide.H"
 #include "ProblemDomain.H"
 #include "RealVect.H"
 
@@ -310,85 +311,163 @@ void BoundaryConditions::fill_grchombo_boundaries(const Side::LoHiSide a_side,
 }
 
 // Used in multigrid solver to update BCs
-void BoundaryConditions::fill_constraint_box(const Side::LoHiSide a_side,
-                                             FArrayBox &a_state,
-                                             const Interval &a_comps)
+void BoundaryConditions::get_constraint_fill_plan(
+    fill_plan_t &a_plan, const Box &a_state_box) const
 {
     CH_assert(is_defined);
-    CH_TIME("BoundaryConditions::fill_constraint_box");
+    a_plan.clear();
 
-    std::vector<int> comps_vector;
-    comps_vector.resize(a_comps.size());
-    std::iota(comps_vector.begin(), comps_vector.end(), a_comps.begin());
-    std::vector<int> psi_comps = {c_psi};
-    std::vector<int> Vi_comps;
-    Interval vector_comps = Interval(c_V1, c_U);
-    Vi_comps.resize(vector_comps.size());
-    std::iota(Vi_comps.begin(), Vi_comps.end(), vector_comps.begin());
+    IntVect offset_lo = -a_state_box.smallEnd() + m_domain_box.smallEnd();
+    IntVect offset_hi = +a_state_box.bigEnd() - m_domain_box.bigEnd();
 
-    // cycle through the directions
+    // reduce box to the intersection of the box and the
+    // problem domain ie remove all outer ghost cells
+    Box this_box = a_state_box;
+    this_box &= m_domain_box;
+
+    // get_boundary_box gives the edges and corners to the highest of their
+    // boundary directions, and these are mirrored from cells in the ghosts
+    // of the lower directions. So filling both sides of one direction
+    // before moving to the next fills everything correctly in one pass.
     FOR(idir)
     {
-        // only do something if this direction is not periodic and solution
-        // boundary enforced in this direction
         if (!m_params.is_periodic[idir])
         {
-            int boundary_condition = get_boundary_condition(a_side, idir);
+            for (SideIterator sit; sit.ok(); ++sit)
+            {
+                Box boundary_box = get_boundary_box(sit(), idir, offset_lo,
+                                                    offset_hi, this_box);
+                if (!boundary_box.isEmpty())
+                {
+                    fill_region_t fill_region;
+                    fill_region.region = boundary_box;
+                    fill_region.side = sit();
+                    fill_region.dir = idir;
+                    fill_region.boundary_condition =
+                        get_boundary_condition(sit(), idir);
+                    a_plan.push_back(fill_region);
+                }
+            }
+        }
+    }
+}
 
-            Box this_box = a_state.box();
-            IntVect offset_lo = -this_box.smallEnd() + m_domain_box.smallEnd();
-            IntVect offset_hi = +this_box.bigEnd() - m_domain_box.bigEnd();
+void BoundaryConditions::fill_constraint_box(FArrayBox &a_state,
+                                             const fill_plan_t &a_plan,
+                                             const Interval &a_comps) const
+{
+    CH_assert(is_defined);
+    CH_TIME("BoundaryConditions::fill_constraint_box");
 
-            // reduce box to the intersection of the box and the
-            // problem domain ie remove all outer ghost cells
-            this_box &= m_domain_box;
-            // get the boundary box (may be Empty)
-            Box boundary_box =
-                get_boundary_box(a_side, idir, offset_lo, offset_hi, this_box);
+    for (const fill_region_t &fill_region : a_plan)
+    {
+        switch (fill_region.boundary_condition)
+        {
+        // simplest case - boundary values are extrapolated
+        case EXTRAPOLATING_BC:
+        {
+            // zero for psi
+            fill_mirrored_region(a_state, fill_region, c_psi, 0.0, -1.0);
 
-            // now we have the appropriate box, fill it!
-            BoxIterator bit(boundary_box);
-            for (bit.begin(); bit.ok(); ++bit)
+            for (int icomp = c_V1; icomp <= c_U; icomp++)
             {
-                IntVect iv = bit();
-                switch (boundary_condition)
+                if (m_params.Vi_extrapolated_at_boundary)
                 {
-                // simplest case - boundary values are extrapolated
-                case EXTRAPOLATING_BC:
+                    fill_nearest_region(a_state, fill_region.region, icomp);
+                }
+                else
                 {
-                    // zero for psi
-                    fill_constant_cell(a_state, iv, a_side, idir, psi_comps,
-                                       0.0);
+                    fill_mirrored_region(a_state, fill_region, icomp, 0.0,
+                                         -1.0);
+                }
+            }
+            break;
+        }
+        // Enforce a reflective symmetry in some direction
+        case REFLECTIVE_BC:
+        {
+            for (int icomp = a_comps.begin(); icomp <= a_comps.end(); icomp++)
+            {
+                int parity = get_var_parity(icomp, fill_region.dir,
+                                            VariableType::constraint);
+                fill_mirrored_region(a_state, fill_region, icomp, 0.0,
+                                     parity);
+            }
+            break;
+        }
+        default:
+            MayDay::Error(
+                "BoundaryCondition::Supplied boundary not supported.");
+        } // end switch
+    }     // end iterate over regions
+}
 
-                    if (m_params.Vi_extrapolated_at_boundary)
-                    {
-                        int extrapolation_order = 0;
-                        fill_extrapolating_cell(a_state, iv, a_side, idir,
-                                                Vi_comps, extrapolation_order);
-                    }
-                    else
-                    {
+void BoundaryConditions::fill_mirrored_region(
+    FArrayBox &a_state, const fill_region_t &a_fill_region, const int a_comp,
+    const Real a_value, const Real a_factor) const
+{
+    const Box &region = a_fill_region.region;
+    const int dir = a_fill_region.dir;
 
-                        fill_constant_cell(a_state, iv, a_side, idir, Vi_comps,
-                                           0.0);
-                    }
-                    break;
+    // the mirror image of cell i in direction dir is mirror_sum - i
+    const int mirror_sum = (a_fill_region.side == Side::Lo)
+                               ? -1
+                               : 2 * m_domain_box.bigEnd(dir) + 1;
+
+    const IntVect &lo = region.smallEnd();
+    const IntVect &hi = region.bigEnd();
+    const int nx = hi[0] - lo[0] + 1;
+    for (int k = lo[2]; k <= hi[2]; k++)
+    {
+        for (int j = lo[1]; j <= hi[1]; j++)
+        {
+            const IntVect row_start(lo[0], j, k);
+            IntVect mirror_start = row_start;
+            mirror_start[dir] = mirror_sum - row_start[dir];
+            Real *out = &a_state(row_start, a_comp);
+            const Real *in = &a_state(mirror_start, a_comp);
+            if (dir == 0)
+            {
+                // the mirror images run backwards along the row
+                for (int i = 0; i < nx; i++)
+                {
+                    out[i] = a_value + a_factor * in[-i];
                 }
-                // Enforce a reflective symmetry in some direction
-                case REFLECTIVE_BC:
+            }
+            else
+            {
+                for (int i = 0; i < nx; i++)
                 {
-                    fill_reflective_cell(a_state, iv, a_side, idir,
-                                         comps_vector,
-                                         VariableType::constraint);
-                    break;
+                    out[i] = a_value + a_factor * in[i];
                 }
-                default:
-                    MayDay::Error(
-                        "BoundaryCondition::Supplied boundary not supported.");
-                } // end switch
-            }     // end iterate over box
-        }         // end isperiodic
-    }             // end idir
+            }
+        }
+    }
+}
+
+void BoundaryConditions::fill_nearest_region(FArrayBox &a_state,
+                                             const Box &a_region,
+                                             const int a_comp) const
+{
+    const IntVect &lo = a_region.smallEnd();
+    const IntVect &hi = a_region.bigEnd();
+    const IntVect &domain_lo = m_domain_box.smallEnd();
+    const IntVect &domain_hi = m_domain_box.bigEnd();
+    for (int k = lo[2]; k <= hi[2]; k++)
+    {
+        const int k_in = std::min(std::max(k, domain_lo[2]), domain_hi[2]);
+        for (int j = lo[1]; j <= hi[1]; j++)
+        {
+            const int j_in = std::min(std::max(j, domain_lo[1]), domain_hi[1]);
+            for (int i = lo[0]; i <= hi[0]; i++)
+            {
+                const int i_in =
+                    std::min(std::max(i, domain_lo[0]), domain_hi[0]);
+                a_state(IntVect(i, j, k), a_comp) =
+                    a_state(IntVect(i_in, j_in, k_in), a_comp);
+            }
+        }
+    }
 }
 
 /// Fill the boundary values appropriately based on the params set
@@ -615,7 +694,7 @@ void BoundaryConditions::fill_extrapolating_cell(
 
 /// Get the boundary condition for a_dir and a_side
 int BoundaryConditions::get_boundary_condition(const Side::LoHiSide a_side,
-                                               const int a_dir)
+                                               const int a_dir) const
 {
     int boundary_condition = 0;
     if (a_side == Side::Lo)
@@ -632,7 +711,8 @@ int BoundaryConditions::get_boundary_condition(const Side::LoHiSide a_side,
 /// get the boundary box to fill if we are at a boundary
 Box BoundaryConditions::get_boundary_box(
     const Side::LoHiSide a_side, const int a_dir, const IntVect &offset_lo,
-    const IntVect &offset_hi, Box &this_ghostless_box, int shrink_for_coarse)
+    const IntVect &offset_hi, Box &this_ghostless_box,
+    int shrink_for_coarse) const
 {
     // default constructor gives empty box
     Box boundary_box;
@@ -22,6 +22,7 @@
 #include "MultigridVariables.hpp"
 #include "ParityDefinitions.hpp"
 #include "VariableType.hpp"
+#include <vector>
 
 // Chombo namespace
 #include "UsingNamespace.H"
@@ -105,10 +106,26 @@ class BoundaryConditions
         const Side::LoHiSide a_side, LevelData<FArrayBox> &a_state,
         const Interval &a_comps = Interval(0, NUM_GRCHOMBO_VARS - 1));
 
-    /// fill constraint box - used to fill output ghosts
+    /// A region of boundary cells of a box and the condition used to fill it
+    struct fill_region_t
+    {
+        Box region;
+        Side::LoHiSide side;
+        int dir;
+        int boundary_condition;
+    };
+    using fill_plan_t = std::vector<fill_region_t>;
+
+    /// work out the boundary regions of a box of constraint vars (including
+    /// edges and corners), ordered so that they can be filled in one pass
+    void get_constraint_fill_plan(fill_plan_t &a_plan,
+                                  const Box &a_state_box) const;
+
+    /// fill constraint box - used in the multigrid solver to fill the
+    /// boundary cells following a plan from get_constraint_fill_plan
     void fill_constraint_box(
-        const Side::LoHiSide a_side, FArrayBox &a_state,
-        const Interval &a_comps = Interval(0, NUM_CONSTRAINT_VARS - 1));
+        FArrayBox &a_state, const fill_plan_t &a_plan,
+        const Interval &a_comps = Interval(0, NUM_CONSTRAINT_VARS - 1)) const;
 
     /// Fill the boundary values appropriately based on the params set
     /// in the direction dir
@@ -121,12 +138,14 @@ class BoundaryConditions
                                  const bool filling_solver_vars = false);
 
     /// Get the boundary condition for a_dir and a_side
-    int get_boundary_condition(const Side::LoHiSide a_side, const int a_dir);
+    int get_boundary_condition(const Side::LoHiSide a_side,
+                               const int a_dir) const;
 
     /// get the boundary box to fill if we are at a boundary
     Box get_boundary_box(const Side::LoHiSide a_side, const int a_dir,
                          const IntVect &offset_lo, const IntVect &offset_hi,
-                         Box &this_ghostless_box, int shrink_for_coarse = 0);
+                         Box &this_ghostless_box,
+                         int shrink_for_coarse = 0) const;
 
     /// This function takes a default constructed open DisjointBoxLayout and
     /// grows the boxes lying along the boundary to include the boundaries if
@@ -156,6 +175,16 @@ class BoundaryConditions
         FArrayBox &out_box, const IntVect iv, const Side::LoHiSide a_side,
         const int dir, const std::vector<int> &reflective_comps,
         const VariableType var_type = VariableType::multigrid) const;
+
+    /// sets a_comp in the region to a_value + a_factor * (mirror image value)
+    void fill_mirrored_region(FArrayBox &a_state,
+                              const fill_region_t &a_fill_region,
+                              const int a_comp, const Real a_value,
+                              const Real a_factor) const;
+
+    /// zeroth order extrapolation of a_comp from the nearest domain cells
+    void fill_nearest_region(FArrayBox &a_state, const Box &a_region,
+                             const int a_comp) const;
 };
 
 /// This derived class is used by expand_grids_to_boundaries to grow the
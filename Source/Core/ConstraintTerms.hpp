@@ -0,0 +1,84 @@
+/* GRTresna
+ * Copyright 2024 The GRTL Collaboration.
+ * Please refer to LICENSE in GRTresna's root directory.
+ */
+
+#ifndef CONSTRAINTTERMS_HPP_
+#define CONSTRAINTTERMS_HPP_
+
+#include "DiagnosticVariables.hpp"
+#include "DimensionDefinitions.hpp"
+#include "EMTensor.hpp"
+#include "FArrayBox.H"
+#include "IntVect.H"
+#include "REAL.H"
+#include "Tensor.hpp"
+#include "UsingNamespace.H"
+
+// Evaluation of the Hamiltonian and Momentum constraints in a cell from
+// quantities that have already been calculated, so that it can be shared
+// between the diagnostics and the methods' elliptic terms
+namespace ConstraintTerms
+{
+inline void set_constraint_terms(FArrayBox &diagnostic_vars_box,
+                                 const IntVect &iv, const Real psi_0,
+                                 const Real K, const Real laplacian_psi_reg,
+                                 const Real A2_0, const emtensor_t &emtensor,
+                                 const Tensor<1, Real, SpaceDim> &d1_K,
+                                 const Tensor<3, Real, SpaceDim> &d2_Vi,
+                                 const Real G_Newton)
+{
+    const Real psim6 = 1.0 / pow(psi_0, 6.0);
+    const Real K_0_squared = K * K;
+
+    diagnostic_vars_box(iv, c_rho) = emtensor.rho;
+    diagnostic_vars_box(iv, c_S1) = emtensor.Si[0];
+    diagnostic_vars_box(iv, c_S2) = emtensor.Si[1];
+    diagnostic_vars_box(iv, c_S3) = emtensor.Si[2];
+
+    diagnostic_vars_box(iv, c_Ham) =
+        K_0_squared - 24.0 * M_PI * G_Newton * emtensor.rho -
+        1.5 * A2_0 * pow(psi_0, -12.0) -
+        12.0 * laplacian_psi_reg * pow(psi_0, -5.0);
+    diagnostic_vars_box(iv, c_Ham_abs) =
+        K_0_squared + 24.0 * M_PI * G_Newton * emtensor.rho +
+        1.5 * abs(A2_0) * pow(psi_0, -12.0) +
+        12.0 * abs(laplacian_psi_reg) * pow(psi_0, -5.0);
+
+    Real Mom1 = -2.0 / 3.0 * d1_K[0] - 8.0 * M_PI * G_Newton * emtensor.Si[0];
+    Real Mom2 = -2.0 / 3.0 * d1_K[1] - 8.0 * M_PI * G_Newton * emtensor.Si[1];
+    Real Mom3 = -2.0 / 3.0 * d1_K[2] - 8.0 * M_PI * G_Newton * emtensor.Si[2];
+
+    Real Mom1_abs = 2.0 / 3.0 * abs(d1_K[0]) +
+                    8.0 * M_PI * G_Newton * abs(emtensor.Si[0]);
+    Real Mom2_abs = 2.0 / 3.0 * abs(d1_K[1]) +
+                    8.0 * M_PI * G_Newton * abs(emtensor.Si[1]);
+    Real Mom3_abs = 2.0 / 3.0 * abs(d1_K[2]) +
+                    8.0 * M_PI * G_Newton * abs(emtensor.Si[2]);
+
+    FOR(i)
+    {
+        Mom1 += psim6 * d2_Vi[0][i][i];
+        Mom2 += psim6 * d2_Vi[1][i][i];
+        Mom3 += psim6 * d2_Vi[2][i][i];
+
+        Mom1_abs += abs(psim6 * d2_Vi[0][i][i]);
+        Mom2_abs += abs(psim6 * d2_Vi[1][i][i]);
+        Mom3_abs += abs(psim6 * d2_Vi[2][i][i]);
+    }
+
+    Real Mom = sqrt(Mom1 * Mom1 + Mom2 * Mom2 + Mom3 * Mom3);
+
+    diagnostic_vars_box(iv, c_Mom1) = Mom1;
+    diagnostic_vars_box(iv, c_Mom2) = Mom2;
+    diagnostic_vars_box(iv, c_Mom3) = Mom3;
+    diagnostic_vars_box(iv, c_Mom) = Mom;
+    diagnostic_vars_box(iv, c_Mom1_abs) = Mom1_abs;
+    diagnostic_vars_box(iv, c_Mom2_abs) = Mom2_abs;
+    diagnostic_vars_box(iv, c_Mom3_abs) = Mom3_abs;
+    diagnostic_vars_box(iv, c_Mom_abs) = sqrt(
+        Mom1_abs * Mom1_abs + Mom2_abs * Mom2_abs + Mom3_abs * Mom3_abs);
+}
+} // namespace ConstraintTerms
+
+#endif /* CONSTRAINTTERMS_HPP_ */
@@ -15,6 +15,7 @@ template <typename method_t, typename matter_t> class Diagnostics
                 const std::array<double, SpaceDim> a_center);
 
     void compute_constraint_terms(LevelData<FArrayBox> *a_multigrid_vars,
+                                  LevelData<FArrayBox> *a_bh_vars,
                                   LevelData<FArrayBox> *a_diagnostic_vars,
                                   LevelData<FArrayBox> *a_rhs,
                                   const RealVect &a_dx) const;
@@ -3,6 +3,7 @@
  * Please refer to LICENSE in GRTresna's root directory.
  */
 
+#include "ConstraintTerms.hpp"
 #include "DerivativeOperators.hpp"
 #include "DiagnosticVariables.hpp"
 
@@ -19,18 +20,22 @@ Diagnostics<method_t, matter_t>::Diagnostics(
 
 template <typename method_t, typename matter_t>
 void Diagnostics<method_t, matter_t>::compute_constraint_terms(
-    LevelData<FArrayBox> *a_multigrid_vars,
+    LevelData<FArrayBox> *a_multigrid_vars, LevelData<FArrayBox> *a_bh_vars,
     LevelData<FArrayBox> *a_diagnostic_vars, LevelData<FArrayBox> *a_rhs,
     const RealVect &a_dx) const
 {
-    DerivativeOperators derivs(a_dx);
     // Iterate through the boxes in turn
     DataIterator dit = a_rhs->dataIterator();
-    for (dit.begin(); dit.ok(); ++dit)
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
     {
-        FArrayBox &multigrid_vars_box = (*a_multigrid_vars)[dit()];
-        FArrayBox &diagnostic_vars_box = (*a_diagnostic_vars)[dit()];
-        FArrayBox &rhs_box = (*a_rhs)[dit()];
+        DataIndex dind = dit[ibox];
+        FArrayBox &multigrid_vars_box = (*a_multigrid_vars)[dind];
+        DerivativeOperators derivs(a_dx, multigrid_vars_box.box());
+        const FArrayBox &bh_vars_box = (*a_bh_vars)[dind];
+        FArrayBox &diagnostic_vars_box = (*a_diagnostic_vars)[dind];
+        FArrayBox &rhs_box = (*a_rhs)[dind];
         Box unghosted_box = rhs_box.box();
 
         // Iterate through the interior of boxes
@@ -45,9 +50,8 @@ void Diagnostics<method_t, matter_t>::compute_constraint_terms(
 
             // Calculate the actual value of psi including BH part
             Real psi_reg = multigrid_vars_box(iv, c_psi_reg);
-            Real psi_bh = psi_and_Aij_functions->compute_bowenyork_psi(loc);
+            Real psi_bh = bh_vars_box(iv, c_psi_bh);
             Real psi_0 = psi_reg + psi_bh;
-            const Real psim6 = 1.0 / pow(psi_0, 6.0);
 
             Real laplacian_psi_reg;
             derivs.scalar_Laplacian(laplacian_psi_reg, iv, multigrid_vars_box,
@@ -61,9 +65,9 @@ void Diagnostics<method_t, matter_t>::compute_constraint_terms(
             // Assign values of Aij
             Tensor<2, Real> Aij_reg;
             method->psi_and_Aij_functions->compute_ctt_Aij(
-                Aij_reg, multigrid_vars_box, iv, a_dx, loc);
+                Aij_reg, multigrid_vars_box, iv, derivs, loc);
             Tensor<2, Real> Aij_bh;
-            psi_and_Aij_functions->compute_bowenyork_Aij(Aij_bh, loc);
+            PsiAndAijFunctions::get_bowenyork_Aij(Aij_bh, bh_vars_box, iv);
             // This is \bar  A_ij \bar A^ij
             Real A2_0 = 0.0;
             FOR2(i, j)
@@ -73,64 +77,12 @@ void Diagnostics<method_t, matter_t>::compute_constraint_terms(
             }
 
             // Compute emtensor components
-            const auto emtensor =
-                matter->compute_emtensor(iv, a_dx, multigrid_vars_box);
-
-            diagnostic_vars_box(iv, c_rho) = emtensor.rho;
-            diagnostic_vars_box(iv, c_S1) = emtensor.Si[0];
-            diagnostic_vars_box(iv, c_S2) = emtensor.Si[1];
-            diagnostic_vars_box(iv, c_S3) = emtensor.Si[2];
-
-            // Set value for K
-            Real K = multigrid_vars_box(iv, c_K_0);
-            Real K_0_squared = K * K;
-
-            diagnostic_vars_box(iv, c_Ham) =
-                K_0_squared - 24.0 * M_PI * G_Newton * emtensor.rho -
-                1.5 * A2_0 * pow(psi_0, -12.0) -
-                12.0 * laplacian_psi_reg * pow(psi_0, -5.0);
-            diagnostic_vars_box(iv, c_Ham_abs) =
-                K_0_squared + 24.0 * M_PI * G_Newton * emtensor.rho +
-                1.5 * abs(A2_0) * pow(psi_0, -12.0) +
-                12.0 * abs(laplacian_psi_reg) * pow(psi_0, -5.0);
-
-            Real Mom1 =
-                -2.0 / 3.0 * d1_K[0] - 8.0 * M_PI * G_Newton * emtensor.Si[0];
-            Real Mom2 =
-                -2.0 / 3.0 * d1_K[1] - 8.0 * M_PI * G_Newton * emtensor.Si[1];
-            Real Mom3 =
-                -2.0 / 3.0 * d1_K[2] - 8.0 * M_PI * G_Newton * emtensor.Si[2];
-
-            Real Mom1_abs = 2.0 / 3.0 * abs(d1_K[0]) +
-                            8.0 * M_PI * G_Newton * abs(emtensor.Si[0]);
-            Real Mom2_abs = 2.0 / 3.0 * abs(d1_K[1]) +
-                            8.0 * M_PI * G_Newton * abs(emtensor.Si[1]);
-            Real Mom3_abs = 2.0 / 3.0 * abs(d1_K[2]) +
-                            8.0 * M_PI * G_Newton * abs(emtensor.Si[2]);
-
-            FOR(i)
-            {
-                Mom1 += psim6 * d2_Vi[0][i][i];
-                Mom2 += psim6 * d2_Vi[1][i][i];
-                Mom3 += psim6 * d2_Vi[2][i][i];
-
-                Mom1_abs += abs(psim6 * d2_Vi[0][i][i]);
-                Mom2_abs += abs(psim6 * d2_Vi[1][i][i]);
-                Mom3_abs += abs(psim6 * d2_Vi[2][i][i]);
-            }
+            const auto emtensor = matter->compute_emtensor(
+                iv, derivs, multigrid_vars_box, bh_vars_box);
 
-            Real Mom = sqrt(Mom1 * Mom1 + Mom2 * Mom2 + Mom3 * Mom3);
-
-            diagnostic_vars_box(iv, c_Mom1) = Mom1;
-            diagnostic_vars_box(iv, c_Mom2) = Mom2;
-            diagnostic_vars_box(iv, c_Mom3) = Mom3;
-            diagnostic_vars_box(iv, c_Mom) = Mom;
-            diagnostic_vars_box(iv, c_Mom1_abs) = Mom1_abs;
-            diagnostic_vars_box(iv, c_Mom2_abs) = Mom2_abs;
-            diagnostic_vars_box(iv, c_Mom3_abs) = Mom3_abs;
-            diagnostic_vars_box(iv, c_Mom_abs) =
-                sqrt(Mom1_abs * Mom1_abs + Mom2_abs * Mom2_abs +
-                     Mom3_abs * Mom3_abs);
+            ConstraintTerms::set_constraint_terms(
+                diagnostic_vars_box, iv, psi_0, multigrid_vars_box(iv, c_K_0),
+                laplacian_psi_reg, A2_0, emtensor, d1_K, d2_Vi, G_Newton);
         }
     }
 }
@@ -141,14 +93,16 @@ void Diagnostics<method_t, matter_t>::normalise_constraints(
     LevelData<FArrayBox> *a_diagnostic_vars, LevelData<FArrayBox> *a_rhs,
     const RealVect &a_dx, IntVect &nCells) const
 {
-    DerivativeOperators derivs(a_dx);
     // Iterate through the boxes in turn
     DataIterator dit = a_rhs->dataIterator();
-    for (dit.begin(); dit.ok(); ++dit)
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
     {
-        FArrayBox &multigrid_vars_box = (*a_multigrid_vars)[dit()];
-        FArrayBox &diagnostic_vars_box = (*a_diagnostic_vars)[dit()];
-        FArrayBox &rhs_box = (*a_rhs)[dit()];
+        DataIndex dind = dit[ibox];
+        FArrayBox &multigrid_vars_box = (*a_multigrid_vars)[dind];
+        FArrayBox &diagnostic_vars_box = (*a_diagnostic_vars)[dind];
+        FArrayBox &rhs_box = (*a_rhs)[dind];
         Box unghosted_box = rhs_box.box();
 
         // Iterate through the interior of boxes
@@ -194,10 +148,13 @@ void Diagnostics<method_t, matter_t>::initialise_diagnostic_vars(
     LevelData<FArrayBox> &a_diagnostic_vars, const RealVect &a_dx) const
 {
     DataIterator dit = a_diagnostic_vars.dataIterator();
-    for (dit.begin(); dit.ok(); ++dit)
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
     {
+        DataIndex dind = dit[ibox];
         // These contain the vars in the boxes, set them all to zero
-        FArrayBox &diagnostic_vars_box = a_diagnostic_vars[dit()];
+        FArrayBox &diagnostic_vars_box = a_diagnostic_vars[dind];
 
         for (int comp = 0; comp < NUM_DIAGNOSTIC_VARS; comp++)
         {
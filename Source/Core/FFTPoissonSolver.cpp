@@ -0,0 +1,289 @@
+/* GRTresna
+ * Copyright 2024 The GRTL Collaboration.
+ * Please refer to LICENSE in GRTresna's root directory.
+ */
+
+#include "FFTPoissonSolver.hpp"
+#include "BoxIterator.H"
+#include "SPMD.H"
+#include "parstream.H"
+#include <algorithm>
+#include <cmath>
+
+FFTPoissonSolver::FFTPoissonSolver(const DisjointBoxLayout &a_grids,
+                                   const ProblemDomain &a_domain, Real a_dx)
+    : m_domain(a_domain), m_dx(a_dx)
+{
+    CH_assert(SpaceDim == 3);
+    for (int idir = 0; idir < SpaceDim; idir++)
+    {
+        if (!m_domain.isPeriodic(idir))
+        {
+            MayDay::Error("FFTPoissonSolver needs a fully periodic domain");
+        }
+    }
+
+    define_slabs(m_z_slabs, 2);
+    define_slabs(m_y_slabs, 1);
+}
+
+void FFTPoissonSolver::define_slabs(DisjointBoxLayout &a_slabs, int a_dir)
+{
+    const Box &domain_box = m_domain.domainBox();
+    const int num_cells = domain_box.size(a_dir);
+    const int num_slabs = std::min(numProc(), num_cells);
+
+    Vector<Box> boxes(num_slabs);
+    Vector<int> procs(num_slabs);
+    const int lo = domain_box.smallEnd(a_dir);
+    for (int islab = 0; islab < num_slabs; islab++)
+    {
+        // spread the cells as evenly as possible over the ranks
+        Box slab = domain_box;
+        slab.setSmall(a_dir, lo + (islab * num_cells) / num_slabs);
+        slab.setBig(a_dir, lo + ((islab + 1) * num_cells) / num_slabs - 1);
+        boxes[islab] = slab;
+        procs[islab] = islab;
+    }
+    a_slabs.define(boxes, procs, m_domain);
+}
+
+std::vector<bool> FFTPoissonSolver::solve(LevelData<FArrayBox> &a_soln,
+                                          const LevelData<FArrayBox> &a_rhs,
+                                          const LevelData<FArrayBox> &a_aCoef,
+                                          const LevelData<FArrayBox> &a_bCoef,
+                                          Real a_alpha, Real a_beta)
+{
+    CH_TIME("FFTPoissonSolver::solve");
+
+    const Box &domain_box = m_domain.domainBox();
+    const IntVect &lo = domain_box.smallEnd();
+    const IntVect num_cells = domain_box.size();
+    const Real inv_num_points = 1.0 / domain_box.numPts();
+    const Real dx2inv = 1.0 / (m_dx * m_dx);
+
+    // magnitudes of the smallest non zero and largest eigenvalues of the
+    // Laplacian stencil
+    Real min_eigenvalue = 4.0 * dx2inv;
+    Real max_eigenvalue = 0.0;
+    for (int idir = 0; idir < SpaceDim; idir++)
+    {
+        min_eigenvalue =
+            std::min(min_eigenvalue,
+                     (2.0 - 2.0 * cos(2.0 * M_PI / num_cells[idir])) * dx2inv);
+        max_eigenvalue += 4.0 * dx2inv;
+    }
+
+    // the real and imaginary parts of one component at a time
+    LevelData<FArrayBox> z_data(m_z_slabs, 2);
+    LevelData<FArrayBox> y_data(m_y_slabs, 2);
+
+    std::vector<bool> exact(a_rhs.nComp(), true);
+    for (int icomp = 0; icomp < a_rhs.nComp(); icomp++)
+    {
+        Real a_mean, a_min, a_max, b_mean, b_min, b_max;
+        get_stats(a_mean, a_min, a_max, a_aCoef, icomp);
+        get_stats(b_mean, b_min, b_max, a_bCoef, icomp);
+        const Real tolerance = 1e-12;
+        if (a_max - a_min > tolerance * std::max(1.0, std::abs(a_mean)) ||
+            b_max - b_min > tolerance * std::max(1.0, std::abs(b_mean)))
+        {
+            exact[icomp] = false;
+        }
+
+        // the operator is diag_term - beta * b * (Laplacian eigenvalue)
+        const Real diag_term = a_alpha * a_mean;
+        const Real lap_term = a_beta * b_mean;
+
+        // the zero mode of the Laplacian is projected out unless aCoef
+        // gives the operator a zero mode of its own. This replaces the
+        // small aCoef that deactivate_zero_mode uses with multigrid.
+        const bool remove_zero_mode =
+            std::abs(diag_term) < 1e-6 * std::abs(lap_term) * min_eigenvalue;
+        const Real min_symbol = 1e-12 * std::abs(lap_term) * max_eigenvalue;
+
+        z_data.setVal(0.0);
+        a_rhs.copyTo(Interval(icomp, icomp), z_data, Interval(0, 0));
+        transform_lines(z_data, 0, false);
+        transform_lines(z_data, 1, false);
+        z_data.copyTo(z_data.interval(), y_data, y_data.interval());
+        transform_lines(y_data, 2, false);
+
+        for (DataIterator dit = y_data.dataIterator(); dit.ok(); ++dit)
+        {
+            FArrayBox &fab = y_data[dit];
+            BoxIterator bit(fab.box());
+            for (bit.begin(); bit.ok(); ++bit)
+            {
+                const IntVect iv = bit();
+                const IntVect k = iv - lo;
+                Real laplacian = 0.0;
+                for (int idir = 0; idir < SpaceDim; idir++)
+                {
+                    laplacian +=
+                        (2.0 * cos(2.0 * M_PI * k[idir] / num_cells[idir]) -
+                         2.0) *
+                        dx2inv;
+                }
+                const Real symbol = diag_term - lap_term * laplacian;
+
+                // also normalise the inverse transform here
+                Real factor = inv_num_points / symbol;
+                if ((k == IntVect::Zero && remove_zero_mode) ||
+                    std::abs(symbol) <= min_symbol)
+                {
+                    factor = 0.0;
+                }
+                fab(iv, 0) *= factor;
+                fab(iv, 1) *= factor;
+            }
+        }
+
+        transform_lines(y_data, 2, true);
+        y_data.copyTo(y_data.interval(), z_data, z_data.interval());
+        transform_lines(z_data, 1, true);
+        transform_lines(z_data, 0, true);
+        z_data.copyTo(Interval(0, 0), a_soln, Interval(icomp, icomp));
+    }
+
+    return exact;
+}
+
+void FFTPoissonSolver::transform_lines(LevelData<FArrayBox> &a_data,
+                                       int a_dir, bool a_inverse)
+{
+    CH_TIME("FFTPoissonSolver::transform_lines");
+
+    for (DataIterator dit = a_data.dataIterator(); dit.ok(); ++dit)
+    {
+        FArrayBox &fab = a_data[dit];
+        const Box &box = fab.box();
+        const int length = box.size(a_dir);
+
+        // the first cell of each line
+        Box line_starts = box;
+        line_starts.setBig(a_dir, box.smallEnd(a_dir));
+        std::vector<IntVect> starts;
+        starts.reserve(line_starts.numPts());
+        BoxIterator bit(line_starts);
+        for (bit.begin(); bit.ok(); ++bit)
+        {
+            starts.push_back(bit());
+        }
+
+        const int num_lines = starts.size();
+#pragma omp parallel for default(shared)
+        for (int iline = 0; iline < num_lines; iline++)
+        {
+            std::vector<complex_t> line(length);
+            IntVect iv = starts[iline];
+            for (int i = 0; i < length; i++, iv[a_dir]++)
+            {
+                line[i] = complex_t(fab(iv, 0), fab(iv, 1));
+            }
+
+            fft(line, a_inverse);
+
+            iv = starts[iline];
+            for (int i = 0; i < length; i++, iv[a_dir]++)
+            {
+                fab(iv, 0) = line[i].real();
+                fab(iv, 1) = line[i].imag();
+            }
+        }
+    }
+}
+
+void FFTPoissonSolver::fft(std::vector<complex_t> &a_data, bool a_inverse)
+{
+    const int n = a_data.size();
+    const Real sign = a_inverse ? 1.0 : -1.0;
+
+    if ((n & (n - 1)) != 0)
+    {
+        // not a power of 2, so do the direct transform
+        std::vector<complex_t> result(n, complex_t(0.0, 0.0));
+        for (int k = 0; k < n; k++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                const Real angle = sign * 2.0 * M_PI * ((j * k) % n) / n;
+                result[k] += a_data[j] * complex_t(cos(angle), sin(angle));
+            }
+        }
+        a_data.swap(result);
+        return;
+    }
+
+    // bit reversal permutation
+    for (int i = 1, j = 0; i < n; i++)
+    {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j)
+        {
+            std::swap(a_data[i], a_data[j]);
+        }
+    }
+
+    // iterative radix 2 butterflies
+    for (int len = 2; len <= n; len <<= 1)
+    {
+        const Real angle = sign * 2.0 * M_PI / len;
+        const complex_t w_len(cos(angle), sin(angle));
+        for (int i = 0; i < n; i += len)
+        {
+            complex_t w(1.0, 0.0);
+            for (int j = 0; j < len / 2; j++)
+            {
+                const complex_t u = a_data[i + j];
+                const complex_t v = a_data[i + j + len / 2] * w;
+                a_data[i + j] = u + v;
+                a_data[i + j + len / 2] = u - v;
+                w *= w_len;
+            }
+        }
+    }
+}
+
+void FFTPoissonSolver::get_stats(Real &a_mean, Real &a_min, Real &a_max,
+                                 const LevelData<FArrayBox> &a_data,
+                                 int a_comp)
+{
+    Real sum = 0.0;
+    Real min = HUGE_VAL;
+    Real max = -HUGE_VAL;
+    long num_points = 0;
+
+    const DisjointBoxLayout &grids = a_data.disjointBoxLayout();
+    for (DataIterator dit = a_data.dataIterator(); dit.ok(); ++dit)
+    {
+        const Box &box = grids[dit];
+        sum += a_data[dit].sum(box, a_comp);
+        min = std::min(min, a_data[dit].min(box, a_comp));
+        max = std::max(max, a_data[dit].max(box, a_comp));
+        num_points += box.numPts();
+    }
+
+#ifdef CH_MPI
+    Real local_values[2] = {sum, (Real)num_points};
+    Real global_values[2];
+    MPI_Allreduce(local_values, global_values, 2, MPI_CH_REAL, MPI_SUM,
+                  Chombo_MPI::comm);
+    sum = global_values[0];
+    num_points = (long)global_values[1];
+
+    Real local_min = min;
+    Real local_max = max;
+    MPI_Allreduce(&local_min, &min, 1, MPI_CH_REAL, MPI_MIN, Chombo_MPI::comm);
+    MPI_Allreduce(&local_max, &max, 1, MPI_CH_REAL, MPI_MAX, Chombo_MPI::comm);
+#endif
+
+    a_mean = sum / num_points;
+    a_min = min;
+    a_max = max;
+}
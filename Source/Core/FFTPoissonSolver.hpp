@@ -0,0 +1,70 @@
+/* GRTresna
+ * Copyright 2024 The GRTL Collaboration.
+ * Please refer to LICENSE in GRTresna's root directory.
+ */
+
+#ifndef FFTPOISSONSOLVER_HPP_
+#define FFTPOISSONSOLVER_HPP_
+
+#include "DisjointBoxLayout.H"
+#include "FArrayBox.H"
+#include "LevelData.H"
+#include "ProblemDomain.H"
+#include "REAL.H"
+#include "UsingNamespace.H"
+#include <complex>
+#include <vector>
+
+/// Spectral solver for (alpha * aCoef - beta * bCoef * Laplacian) u = rhs on
+/// a single, fully periodic level, which can be used instead of multigrid.
+/// It divides by the eigenvalues of the same second order stencil as the
+/// operator, so components with constant coefficients (e.g. V_i and U in the
+/// cosmology examples) are solved exactly. Components with varying
+/// coefficients (psi) are solved with their mean coefficients, which only
+/// gives an approximate solution that can be refined by the linear solver.
+/// If the operator has no zero mode of its own (aCoef ~ 0) the zero mode
+/// is projected out exactly.
+/// The level is redistributed into slabs with copyTo, first split in z so
+/// that the x and y transforms are local to each rank, then split in y for
+/// the z transforms.
+class FFTPoissonSolver
+{
+  public:
+    FFTPoissonSolver(const DisjointBoxLayout &a_grids,
+                     const ProblemDomain &a_domain, Real a_dx);
+
+    /// Overwrites a_soln with the solution for each component. Returns for
+    /// each component whether its coefficients are constant, so that its
+    /// solution is exact.
+    std::vector<bool> solve(LevelData<FArrayBox> &a_soln,
+                            const LevelData<FArrayBox> &a_rhs,
+                            const LevelData<FArrayBox> &a_aCoef,
+                            const LevelData<FArrayBox> &a_bCoef, Real a_alpha,
+                            Real a_beta);
+
+  private:
+    typedef std::complex<Real> complex_t;
+
+    /// in place FFT, radix 2 if the length is a power of 2, otherwise a
+    /// direct DFT. The inverse is not normalised.
+    static void fft(std::vector<complex_t> &a_data, bool a_inverse);
+
+    /// transform all the lines in direction a_dir of the boxes of a_data,
+    /// which hold the real and imaginary parts in components 0 and 1
+    static void transform_lines(LevelData<FArrayBox> &a_data, int a_dir,
+                                bool a_inverse);
+
+    /// mean, min and max of a_comp over the level
+    static void get_stats(Real &a_mean, Real &a_min, Real &a_max,
+                          const LevelData<FArrayBox> &a_data, int a_comp);
+
+    /// layout of slabs covering the domain, split in a_dir between ranks
+    void define_slabs(DisjointBoxLayout &a_slabs, int a_dir);
+
+    ProblemDomain m_domain;
+    Real m_dx;
+    DisjointBoxLayout m_z_slabs;
+    DisjointBoxLayout m_y_slabs;
+};
+
+#endif /* FFTPOISSONSOLVER_HPP_ */
@@ -6,11 +6,15 @@
 #ifndef GRSOLVER_HPP_
 #define GRSOLVER_HPP_
 
+#include "AndersonMixing.hpp"
+#include "AsyncOutputWriter.hpp"
 #include "Diagnostics.hpp"
+#include "FFTPoissonSolver.hpp"
 #include "GRParmParse.hpp"
 #include "PsiAndAijFunctions.hpp"
 #include "SimulationParameters.hpp"
 #include "TaggingCriterion.hpp"
+#include "VariableCoeffPoissonOperator.H"
 
 /*
 Class that manages high-level solver functionality, independent of specific
@@ -21,19 +25,77 @@ template <class method_t, class matter_t> class GRSolver
   public:
     GRSolver(GRParmParse &pp);
 
+    // Uses the given parameters instead of reading them from pp, e.g. to
+    // run the same problem with different solver options
+    GRSolver(GRParmParse &pp,
+             const SimulationParameters<method_t, matter_t> &a_params);
+
     void setup();
 
     int run();
 
+    // The relative errors of the final solution, in %
+    Real get_Ham_error() const { return Ham_error; }
+    Real get_Mom_error() const { return Mom_error; }
+
+    const Vector<LevelData<FArrayBox> *> &get_multigrid_vars() const
+    {
+        return multigrid_vars;
+    }
+
+    Grids &get_grids() const { return *grids; }
+
     ~GRSolver();
 
   private:
+    // Allocates the objects used by the solver, once params is set
+    void init();
+
+    // Reasons for leaving the NL loop
+    enum NL_status_t
+    {
+        NL_NOT_CONVERGED,
+        NL_ERROR_TOLERANCE,
+        NL_RELATIVE_TOLERANCE,
+        NL_UPDATE_TOLERANCE,
+        NL_STAGNATED,
+        NL_MAX_ITERATIONS
+    };
+
     void create_vars();
 
     void calculate_diagnostics(const int NL_iter);
 
-    Real Ham_error;
-    Real Mom_error;
+    // Recomputes the errors on the current solution, for the final report
+    void compute_final_errors(const int NL_iter);
+
+    // Nonlinear smoothing of psi on all levels
+    void relax_psi();
+
+    // Whether the constraint errors are computed at this NL iteration,
+    // set by error_check_interval
+    bool errors_needed(const int NL_iter) const;
+
+    // Checks the current errors against the NL stopping criteria
+    NL_status_t check_error_convergence() const;
+
+    // Norm of the correction found in the last linear solve
+    Real compute_update_norm();
+
+    void print_NL_status(const NL_status_t a_status) const;
+
+    // Eisenstat-Walker forcing term for the linear solve
+    Real compute_linear_tolerance();
+
+    // The constraint components whose operator has the constants as its
+    // null space (fully periodic and aCoef = 0), which are deflated in the
+    // linear solve when deflate_zero_mode is set
+    std::vector<int> get_zero_mode_comps();
+
+    // Restart checkpoints of the NL solve, which hold the grids,
+    // multigrid_vars, constraint_vars, the NL iteration and the errors
+    void write_checkpoint(const int NL_iter) const;
+    void read_checkpoint();
 
     GRParmParse pp;
     SimulationParameters<method_t, matter_t> params;
@@ -50,16 +112,35 @@ template <class method_t, class matter_t> class GRSolver
     Grids *grids;
     TaggingCriterion *tagging_criterion;
 
+    AndersonMixing *anderson_mixing;
+
+    // only used on a single fully periodic level
+    FFTPoissonSolver *fft_solver;
+
+    // writes the diagnostic files in the background, if async_output is set
+    AsyncOutputWriter *output_writer;
+
     MultilevelLinearOp<FArrayBox> mlOp;
     BiCGStabSolver<Vector<LevelData<FArrayBox> *>> solver;
 
     Vector<LevelData<FArrayBox> *> multigrid_vars;
+    Vector<LevelData<FArrayBox> *> bh_vars; // Bowen York psi and Aij
 
     Vector<LevelData<FArrayBox> *> constraint_vars;
     Vector<LevelData<FArrayBox> *> rhs;
     Vector<LevelData<FArrayBox> *> diagnostic_vars;
     Vector<RefCountedPtr<LevelData<FArrayBox>>> aCoef;
     Vector<RefCountedPtr<LevelData<FArrayBox>>> bCoef;
+
+    // the NL iteration to start from, only non zero on restart
+    int first_NL_iter;
+
+    Real Ham_error;
+    Real Mom_error;
+    Real linear_tolerance;
+
+    std::vector<Real> Ham_error_history;
+    std::vector<Real> Mom_error_history;
 };
 
 #include "GRSolver.impl.hpp"
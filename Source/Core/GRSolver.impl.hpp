@@ -14,13 +14,35 @@
 #include "RHSTagging.hpp"
 #include "WriteFile.hpp"
 #include "WriteOutput.H"
+#include <algorithm>
 
 template <class method_t, class matter_t>
 GRSolver<method_t, matter_t>::GRSolver(GRParmParse &a_pp)
     : pp(a_pp), params(pp), numLevels(params.grid_params.numLevels),
-      multigrid_vars(numLevels, NULL), constraint_vars(numLevels, NULL),
-      rhs(numLevels, NULL), aCoef(numLevels), bCoef(numLevels),
-      diagnostic_vars(numLevels, NULL), Ham_error(0.), Mom_error(0.)
+      multigrid_vars(numLevels, NULL), bh_vars(numLevels, NULL),
+      constraint_vars(numLevels, NULL),
+      rhs(numLevels, NULL), diagnostic_vars(numLevels, NULL),
+      aCoef(numLevels), bCoef(numLevels), first_NL_iter(0), Ham_error(0.),
+      Mom_error(0.), linear_tolerance(0.)
+{
+    init();
+}
+
+template <class method_t, class matter_t>
+GRSolver<method_t, matter_t>::GRSolver(
+    GRParmParse &a_pp, const SimulationParameters<method_t, matter_t> &a_params)
+    : pp(a_pp), params(a_params), numLevels(params.grid_params.numLevels),
+      multigrid_vars(numLevels, NULL), bh_vars(numLevels, NULL),
+      constraint_vars(numLevels, NULL),
+      rhs(numLevels, NULL), diagnostic_vars(numLevels, NULL),
+      aCoef(numLevels), bCoef(numLevels), first_NL_iter(0), Ham_error(0.),
+      Mom_error(0.), linear_tolerance(0.)
+{
+    init();
+}
+
+template <class method_t, class matter_t>
+void GRSolver<method_t, matter_t>::init()
 {
     psi_and_Aij_functions = new PsiAndAijFunctions(params.psi_and_Aij_params);
     matter = new matter_t(params.matter_params, psi_and_Aij_functions,
@@ -37,6 +59,39 @@ GRSolver<method_t, matter_t>::GRSolver(GRParmParse &a_pp)
     diagnostics = new Diagnostics<method_t, matter_t>(
         method, matter, psi_and_Aij_functions, params.base_params.G_Newton,
         params.grid_params.center);
+    fft_solver = NULL;
+    output_writer = NULL;
+    if (params.base_params.async_output)
+    {
+        // Chombo's writer uses collectives on the global communicator,
+        // which cannot overlap with those of the solver, and even on one
+        // rank it makes MPI calls from the writer thread. Chombo's timers
+        // are not thread safe, so they must be compiled out.
+        bool threads_supported = AsyncOutputWriter::is_available();
+#ifdef CH_MPI
+        int thread_level;
+        MPI_Query_thread(&thread_level);
+        threads_supported &= (thread_level == MPI_THREAD_MULTIPLE);
+#endif
+        if (numProc() == 1 && threads_supported)
+        {
+            output_writer =
+                new AsyncOutputWriter(params.base_params.async_output_queue);
+        }
+        else
+        {
+            pout() << "async_output is only used on a single rank (with "
+                   << "MPI_THREAD_MULTIPLE) in builds without timers, "
+                   << "writing the diagnostic files synchronously" << endl;
+        }
+    }
+    anderson_mixing = NULL;
+    if (params.base_params.use_anderson_mixing)
+    {
+        anderson_mixing =
+            new AndersonMixing(params.base_params.anderson_depth,
+                               params.base_params.anderson_mixing);
+    }
 }
 
 template <class method_t, class matter_t>
@@ -44,7 +99,12 @@ void GRSolver<method_t, matter_t>::setup()
 {
     // set up the grids, using the rhs for tagging to decide
     // where needs additional levels
-    if (params.base_params.readin_matter_data)
+    if (params.base_params.restart)
+    {
+        // the grids of the checkpoint are used as they are, no tagging
+        grids->read_grids(params.base_params.restart_file);
+    }
+    else if (params.base_params.readin_matter_data)
     {
         grids->read_grids(params.base_params.input_filename);
     }
@@ -54,11 +114,48 @@ void GRSolver<method_t, matter_t>::setup()
     }
 
     create_vars();
+    if (params.base_params.restart)
+    {
+        read_checkpoint();
+    }
 
     mlOp.m_num_mg_iterations = params.base_params.numMGIter;
     mlOp.m_num_mg_smooth = params.base_params.numMGSmooth;
     mlOp.m_preCondSolverDepth = params.base_params.preCondSolverDepth;
 
+    // relax mode 2 uses overlapGSRB in the smoother, 1 the standard levelGSRB
+    AMRPoissonOp::s_relaxMode = params.base_params.overlap_exchange ? 2 : 1;
+    VariableCoeffPoissonOperator::s_interleavedGSRB =
+        params.base_params.interleaved_smoother;
+    VariableCoeffPoissonOperator::s_chebyshevSmoother =
+        params.base_params.chebyshev_smoother;
+    VariableCoeffPoissonOperator::s_singlePrecisionSmoother =
+        params.base_params.single_precision_smoother;
+    VariableCoeffPoissonOperator::s_directBottomSolve =
+        params.base_params.direct_bottom_solve;
+    VariableCoeffPoissonOperator::s_maxDirectBottomCells =
+        params.base_params.max_direct_bottom_cells;
+
+    if (params.base_params.use_fft_solver)
+    {
+        bool fully_periodic = true;
+        for (int idir = 0; idir < SpaceDim; idir++)
+        {
+            fully_periodic &= grids->vectDomain[0].isPeriodic(idir);
+        }
+        if (fully_periodic && numLevels == 1)
+        {
+            fft_solver = new FFTPoissonSolver(grids->grids_data[0],
+                                              grids->vectDomain[0],
+                                              grids->vectDx[0][0]);
+        }
+        else
+        {
+            pout() << "The FFT solver needs a single fully periodic level, "
+                   << "using multigrid instead" << endl;
+        }
+    }
+
     // define the multi level operator
     grids->define_operator(mlOp, aCoef, bCoef, params.base_params.alpha,
                            params.base_params.beta);
@@ -70,9 +167,19 @@ void GRSolver<method_t, matter_t>::setup()
     solver.m_normType = 2;
     solver.m_eps = params.base_params.iter_tolerance;
     solver.m_imax = params.base_params.max_iter;
+    // the adaptive tolerance is only updated at the steps that compute the
+    // errors, so carry on with the one of the checkpointed run until then
+    if (params.base_params.restart && params.base_params.adaptive_tolerance &&
+        linear_tolerance > 0.)
+    {
+        solver.m_eps = linear_tolerance;
+    }
 
-    output_solver_data(constraint_vars, multigrid_vars, diagnostic_vars,
-                       grids->grids_data, params, 0);
+    if (!params.base_params.restart)
+    {
+        output_solver_data(constraint_vars, multigrid_vars, diagnostic_vars,
+                           grids->grids_data, params, 0, output_writer);
+    }
 }
 
 template <class method_t, class matter_t>
@@ -83,40 +190,132 @@ int GRSolver<method_t, matter_t>::run()
     bool filling_solver_vars = false;
     grids->fill_ghosts_correct_coarse(multigrid_vars, filling_solver_vars);
 
-    openFile(params.base_params.error_filename);
-    for (int NL_iter = 0; NL_iter < params.base_params.max_NL_iter; NL_iter++)
+    // on restart the errors are appended to those of the previous run
+    if (!params.base_params.restart)
+    {
+        openFile(params.base_params.error_filename);
+    }
+    NL_status_t NL_status = NL_NOT_CONVERGED;
+    // whether Ham_error and Mom_error are those of the current solution
+    bool errors_current = false;
+    // the exit status of the last linear step, as BiCGStabSolver reports it
+    // (1 is success), which is also success if the FFT solved it exactly
+    // or if there was no linear step
+    int linear_status = 1;
+    int NL_iter = first_NL_iter;
+    for (; NL_iter < params.base_params.max_NL_iter; NL_iter++)
     {
         pout() << "Main Loop Iteration " << (NL_iter + 1) << " out of "
                << params.base_params.max_NL_iter << endl;
 
+        relax_psi();
+
         for (int ilev = 0; ilev < numLevels; ilev++)
         {
             RealVect dxLevel = grids->vectDx[ilev];
-            method->solve_analytic(multigrid_vars[ilev], rhs[ilev],
-                                   grids->vectDx[ilev]);
+            method->solve_analytic(multigrid_vars[ilev], bh_vars[ilev],
+                                   rhs[ilev], grids->vectDx[ilev]);
         }
         filling_solver_vars = false;
         grids->fill_ghosts_correct_coarse(multigrid_vars, filling_solver_vars);
 
+        // the constraint terms are only filled in the method sweep when
+        // the errors are needed at this step
+        const bool compute_errors = errors_needed(NL_iter);
         for (int ilev = 0; ilev < numLevels; ilev++)
         {
             RealVect dxLevel = grids->vectDx[ilev];
-            method->set_elliptic_terms(multigrid_vars[ilev], rhs[ilev],
-                                       aCoef[ilev], bCoef[ilev],
-                                       grids->vectDx[ilev]);
+            method->set_elliptic_terms(
+                multigrid_vars[ilev], bh_vars[ilev], rhs[ilev], aCoef[ilev],
+                bCoef[ilev], grids->vectDx[ilev],
+                compute_errors ? diagnostic_vars[ilev] : NULL);
         }
 
-        calculate_diagnostics(NL_iter);
+        if (compute_errors)
+        {
+            calculate_diagnostics(NL_iter);
+            errors_current = true;
+
+            // No need for another linear step if the data already
+            // satisfies the constraints to the requested accuracy
+            NL_status = check_error_convergence();
+            if (NL_status != NL_NOT_CONVERGED)
+            {
+                break;
+            }
+        }
 
-        grids->define_operator(mlOp, aCoef, bCoef, params.base_params.alpha,
-                               params.base_params.beta);
-        bool homogeneousBC = false;
-        solver.define(&mlOp, homogeneousBC);
+        // the operators of mlOp (and the solver) are kept from setup, only
+        // the new coefficients are passed on to them
+        grids->update_operator_coefficients();
+        // the tolerance is kept until new errors are available
+        if (params.base_params.adaptive_tolerance && compute_errors)
+        {
+            solver.m_eps = compute_linear_tolerance();
+            pout() << "Linear solver tolerance for this step is "
+                   << solver.m_eps << endl;
+        }
 
-        solver.solve(constraint_vars, rhs);
+        // deflate the constant null space of the operator: project the
+        // rhs onto its range (and the initial guess orthogonal to the null
+        // space) here, and fix the mean of the solution after the solve
+        std::vector<int> zero_mode_comps = get_zero_mode_comps();
+        std::vector<Grids::reduction_t> initial_means, soln_means;
+        for (int comp : zero_mode_comps)
+        {
+            Interval interval(comp, comp);
+            initial_means.push_back({rhs, interval, false});
+            soln_means.push_back({constraint_vars, interval, false});
+        }
+        initial_means.insert(initial_means.end(), soln_means.begin(),
+                             soln_means.end());
+        grids->remove_mean(initial_means);
+
+        if (anderson_mixing)
+        {
+            anderson_mixing->store_previous(multigrid_vars, rhs, mlOp);
+        }
+
+        // the FFT solution is exact for the components with constant
+        // coefficients, otherwise it is the initial guess for the linear
+        // solver, which is then kept for the exact components
+        std::vector<bool> fft_exact(NUM_CONSTRAINT_VARS, false);
+        if (fft_solver)
+        {
+            fft_exact = fft_solver->solve(
+                *constraint_vars[0], *rhs[0], *aCoef[0], *bCoef[0],
+                params.base_params.alpha, params.base_params.beta);
+        }
+        linear_status = 1;
+        if (std::find(fft_exact.begin(), fft_exact.end(), false) !=
+            fft_exact.end())
+        {
+            LevelData<FArrayBox> fft_soln;
+            if (fft_solver)
+            {
+                fft_soln.define(*constraint_vars[0]);
+            }
+            solver.solve(constraint_vars, rhs);
+            linear_status = solver.m_exitStatus;
+            for (int comp = 0; comp < NUM_CONSTRAINT_VARS; comp++)
+            {
+                if (fft_exact[comp])
+                {
+                    fft_soln.copyTo(Interval(comp, comp), *constraint_vars[0],
+                                    Interval(comp, comp));
+                }
+            }
+        }
+        grids->remove_mean(soln_means);
 
         grids->update_psi0(multigrid_vars, constraint_vars,
                            params.method_params.deactivate_zero_mode);
+        errors_current = false;
+
+        if (anderson_mixing)
+        {
+            anderson_mixing->mix(multigrid_vars, mlOp);
+        }
 
         bool filling_solver_vars = true;
         grids->fill_ghosts_correct_coarse(multigrid_vars, filling_solver_vars);
@@ -127,12 +326,48 @@ int GRSolver<method_t, matter_t>::run()
         if (params.base_params.write_diagnostics && at_diagnostic_interval)
         {
             output_solver_data(constraint_vars, multigrid_vars, diagnostic_vars,
-                               grids->grids_data, params, NL_iter + 1);
+                               grids->grids_data, params, NL_iter + 1,
+                               output_writer);
         }
+
+        if (params.base_params.checkpoint_interval > 0 &&
+            (NL_iter + 1) % params.base_params.checkpoint_interval == 0)
+        {
+            write_checkpoint(NL_iter + 1);
+        }
+
+        // Stop if the linear step no longer changes the solution
+        if (params.base_params.NL_update_tolerance > 0.0)
+        {
+            Real update_norm = compute_update_norm();
+            pout() << "The norm of the update at step " << NL_iter << " is "
+                   << update_norm << endl;
+            if (update_norm < params.base_params.NL_update_tolerance)
+            {
+                NL_status = NL_UPDATE_TOLERANCE;
+                break;
+            }
+        }
+    }
+
+    if (NL_status == NL_NOT_CONVERGED)
+    {
+        NL_status = NL_MAX_ITERATIONS;
     }
 
-    pout() << "Converged!" << endl
-           << "Ham relative error: " << Ham_error << " %" << endl
+    // unless the loop stopped on the errors, the last ones were computed
+    // before the final linear step (or several steps before it with
+    // error_check_interval), so evaluate them again on the solution that
+    // is written out
+    if (!errors_current)
+    {
+        // the break on the update norm comes at the end of step NL_iter
+        int final_iter =
+            (NL_status == NL_UPDATE_TOLERANCE) ? NL_iter + 1 : NL_iter;
+        compute_final_errors(final_iter);
+    }
+    print_NL_status(NL_status);
+    pout() << "Ham relative error: " << Ham_error << " %" << endl
            << "Mom relative error: " << Mom_error << " %" << endl;
 
     // Mayday if result not converged (> 100% error)
@@ -142,55 +377,92 @@ int GRSolver<method_t, matter_t>::run()
             "NL iterations did not converge - may need a better initial guess");
     }
 
-    output_final_data(multigrid_vars, grids->grids_data, grids->vectDx,
-                      grids->vectDomain, params,
+    // finish the diagnostic files before the final output
+    if (output_writer)
+    {
+        output_writer->wait();
+    }
+
+    output_final_data(multigrid_vars, bh_vars, grids->grids_data,
+                      grids->vectDx, grids->vectDomain, params,
                       params.base_params.output_filename);
 
-    int exitStatus = solver.m_exitStatus;
+    int exitStatus = linear_status;
     // note that for AMRMultiGrid, success = 1.
     exitStatus -= 1;
     return exitStatus;
 }
 
+template <typename method_t, typename matter_t>
+void GRSolver<method_t, matter_t>::relax_psi()
+{
+    // Red-black sweeps, refilling the ghosts after each colour
+    for (int ismooth = 0; ismooth < params.base_params.num_NL_smooth;
+         ismooth++)
+    {
+        for (int colour = 0; colour <= 1; colour++)
+        {
+            for (int ilev = 0; ilev < numLevels; ilev++)
+            {
+                method->relax_psi(multigrid_vars[ilev], bh_vars[ilev],
+                                  grids->vectDx[ilev], colour);
+            }
+            bool filling_solver_vars = true;
+            grids->fill_ghosts_correct_coarse(multigrid_vars,
+                                              filling_solver_vars);
+        }
+    }
+}
+
 template <typename method_t, typename matter_t>
 void GRSolver<method_t, matter_t>::calculate_diagnostics(const int NL_iter)
 {
+    // the constraint terms were already filled in the same sweep as the
+    // elliptic terms, so only the normalisation is needed here
+    for (int ilev = 0; ilev < numLevels; ilev++)
+    {
+        RealVect dxLevel = grids->vectDx[ilev];
+        diagnostics->normalise_constraints(multigrid_vars[ilev],
+                                           diagnostic_vars[ilev], rhs[ilev],
+                                           dxLevel, params.grid_params.nCells);
+    }
+
+    // all the global reductions are done in one batch, with a single
+    // all-reduce
+    std::vector<Grids::reduction_t> reductions = {
+        {diagnostic_vars, Interval(c_Ham, c_Ham), true},
+        {diagnostic_vars, Interval(c_Mom, c_Mom), true},
+        {diagnostic_vars, Interval(c_Ham_abs, c_Ham_abs), true},
+        {diagnostic_vars, Interval(c_Mom_abs, c_Mom_abs), true}};
+    const int num_norms = reductions.size();
+    if (params.grid_params.periodic_directions_exist)
+    {
+        // the integrals of the rhs, for the integrability condition
+        for (int icomp = 0; icomp < NUM_CONSTRAINT_VARS; icomp++)
+        {
+            reductions.push_back({rhs, Interval(icomp, icomp), false});
+        }
+    }
+    std::vector<Real> results;
+    grids->compute_reductions(results, reductions);
+
     if (params.grid_params.periodic_directions_exist)
     {
-        // Calculate values for integrand here
         pout() << "Computing integrability of rhs for periodic domain... "
                << endl;
         for (int icomp = 0; icomp < NUM_CONSTRAINT_VARS; icomp++)
         {
-            Real integral = grids->compute_sum(rhs, Interval(icomp, icomp));
+            Real integral = results[num_norms + icomp];
 
             pout() << "Integral of rhs " << icomp << " is " << integral << endl;
             pout() << "(This should be a small number)" << endl;
         }
     }
 
-    for (int ilev = 0; ilev < numLevels; ilev++)
-    {
-        RealVect dxLevel = grids->vectDx[ilev];
-        diagnostics->compute_constraint_terms(
-            multigrid_vars[ilev], diagnostic_vars[ilev], rhs[ilev], dxLevel);
-    }
-
-    for (int ilev = 0; ilev < numLevels; ilev++)
-    {
-        RealVect dxLevel = grids->vectDx[ilev];
-        diagnostics->normalise_constraints(multigrid_vars[ilev],
-                                           diagnostic_vars[ilev], rhs[ilev],
-                                           dxLevel, params.grid_params.nCells);
-    }
-    Real Ham_norm =
-        grids->compute_norm(diagnostic_vars, Interval(c_Ham, c_Ham));
-    Real Mom_norm =
-        grids->compute_norm(diagnostic_vars, Interval(c_Mom, c_Mom));
-    Real Ham_abs_norm =
-        grids->compute_norm(diagnostic_vars, Interval(c_Ham_abs, c_Ham_abs));
-    Real Mom_abs_norm =
-        grids->compute_norm(diagnostic_vars, Interval(c_Mom_abs, c_Mom_abs));
+    Real Ham_norm = results[0];
+    Real Mom_norm = results[1];
+    Real Ham_abs_norm = results[2];
+    Real Mom_abs_norm = results[3];
 
     Ham_error = 100 * Ham_norm / Ham_abs_norm;
     Mom_error = 100 * Mom_norm / Mom_abs_norm;
@@ -200,6 +472,216 @@ void GRSolver<method_t, matter_t>::calculate_diagnostics(const int NL_iter)
     pout() << "The relative error of Mom before step " << NL_iter << " is "
            << Mom_error << " %" << endl;
     writeFile(params.base_params.error_filename, NL_iter, Ham_error, Mom_error);
+
+    Ham_error_history.push_back(Ham_error);
+    Mom_error_history.push_back(Mom_error);
+}
+
+template <typename method_t, typename matter_t>
+void GRSolver<method_t, matter_t>::compute_final_errors(const int NL_iter)
+{
+    // the same steps as at the start of an NL iteration, without the
+    // smoothing of psi, so that the errors describe the final iterate
+    for (int ilev = 0; ilev < numLevels; ilev++)
+    {
+        method->solve_analytic(multigrid_vars[ilev], bh_vars[ilev], rhs[ilev],
+                               grids->vectDx[ilev]);
+    }
+    bool filling_solver_vars = false;
+    grids->fill_ghosts_correct_coarse(multigrid_vars, filling_solver_vars);
+
+    for (int ilev = 0; ilev < numLevels; ilev++)
+    {
+        method->set_elliptic_terms(multigrid_vars[ilev], bh_vars[ilev],
+                                   rhs[ilev], aCoef[ilev], bCoef[ilev],
+                                   grids->vectDx[ilev], diagnostic_vars[ilev]);
+    }
+    calculate_diagnostics(NL_iter);
+}
+
+template <typename method_t, typename matter_t>
+bool GRSolver<method_t, matter_t>::errors_needed(const int NL_iter) const
+{
+    // the first errors are the reference for the relative tolerance (the
+    // final ones are computed after the loop)
+    if (NL_iter == 0)
+    {
+        return true;
+    }
+
+    // the diagnostic vars are written out at the end of this step
+    if (params.base_params.write_diagnostics &&
+        (NL_iter + 1) % params.base_params.diagnostic_interval == 0)
+    {
+        return true;
+    }
+
+    return NL_iter % params.base_params.error_check_interval == 0;
+}
+
+template <typename method_t, typename matter_t>
+typename GRSolver<method_t, matter_t>::NL_status_t
+GRSolver<method_t, matter_t>::check_error_convergence() const
+{
+    const Real Ham_tolerance = params.base_params.NL_Ham_tolerance;
+    const Real Mom_tolerance = params.base_params.NL_Mom_tolerance;
+
+    // absolute thresholds, only those which are set need to be met
+    if (Ham_tolerance > 0.0 || Mom_tolerance > 0.0)
+    {
+        bool Ham_converged =
+            (Ham_tolerance <= 0.0) || (Ham_error < Ham_tolerance);
+        bool Mom_converged =
+            (Mom_tolerance <= 0.0) || (Mom_error < Mom_tolerance);
+        if (Ham_converged && Mom_converged)
+        {
+            return NL_ERROR_TOLERANCE;
+        }
+    }
+
+    // reduction relative to the errors of the initial guess
+    const Real relative_tolerance = params.base_params.NL_relative_tolerance;
+    if (relative_tolerance > 0.0 &&
+        Ham_error <= relative_tolerance * Ham_error_history[0] &&
+        Mom_error <= relative_tolerance * Mom_error_history[0])
+    {
+        return NL_RELATIVE_TOLERANCE;
+    }
+
+    // stagnation - neither error has improved over the last few steps
+    const int stagnation_iter = params.base_params.NL_stagnation_iter;
+    const int num_steps = Ham_error_history.size();
+    if (stagnation_iter > 0 && num_steps > stagnation_iter)
+    {
+        const Real factor = params.base_params.NL_stagnation_factor;
+        Real Ham_error_old = Ham_error_history[num_steps - 1 - stagnation_iter];
+        Real Mom_error_old = Mom_error_history[num_steps - 1 - stagnation_iter];
+        if (Ham_error > factor * Ham_error_old &&
+            Mom_error > factor * Mom_error_old)
+        {
+            return NL_STAGNATED;
+        }
+    }
+
+    return NL_NOT_CONVERGED;
+}
+
+template <typename method_t, typename matter_t>
+Real GRSolver<method_t, matter_t>::compute_update_norm()
+{
+    // psi is always updated incrementally, the other constraint vars
+    // are only increments when the zero mode is deactivated
+    int last_comp = params.method_params.deactivate_zero_mode
+                        ? NUM_CONSTRAINT_VARS - 1
+                        : c_psi;
+    return grids->compute_norm(constraint_vars, Interval(c_psi, last_comp));
+}
+
+template <typename method_t, typename matter_t>
+std::vector<int> GRSolver<method_t, matter_t>::get_zero_mode_comps()
+{
+    std::vector<int> zero_mode_comps;
+    if (!params.method_params.deflate_zero_mode)
+    {
+        return zero_mode_comps;
+    }
+    for (int idir = 0; idir < SpaceDim; idir++)
+    {
+        if (!params.grid_params.periodic[idir])
+        {
+            return zero_mode_comps;
+        }
+    }
+
+    Vector<LevelData<FArrayBox> *> aCoef_ptrs(numLevels);
+    for (int ilev = 0; ilev < numLevels; ilev++)
+    {
+        aCoef_ptrs[ilev] = &(*aCoef[ilev]);
+    }
+    // aCoef changes with psi, so this is redone every step, but with all
+    // the components in one batch
+    std::vector<Grids::reduction_t> aCoef_norms;
+    for (int icomp = 0; icomp < NUM_CONSTRAINT_VARS; icomp++)
+    {
+        aCoef_norms.push_back({aCoef_ptrs, Interval(icomp, icomp), true});
+    }
+    std::vector<Real> results;
+    grids->compute_reductions(results, aCoef_norms);
+    for (int icomp = 0; icomp < NUM_CONSTRAINT_VARS; icomp++)
+    {
+        if (params.base_params.alpha * results[icomp] == 0.0)
+        {
+            zero_mode_comps.push_back(icomp);
+        }
+    }
+    return zero_mode_comps;
+}
+
+template <typename method_t, typename matter_t>
+Real GRSolver<method_t, matter_t>::compute_linear_tolerance()
+{
+    // Choice 2 in Eisenstat & Walker (1996) with gamma = 0.9 and
+    // alpha = (1 + sqrt(5)) / 2, using the larger of the two relative
+    // errors as the size of the NL residual
+    const Real gamma = 0.9;
+    const Real alpha = 0.5 * (1.0 + sqrt(5.0));
+    const Real max_tolerance = params.base_params.max_adaptive_tolerance;
+    const Real min_tolerance = params.base_params.iter_tolerance;
+
+    const int num_steps = Ham_error_history.size();
+    if (num_steps < 2)
+    {
+        linear_tolerance = max_tolerance;
+        return linear_tolerance;
+    }
+
+    Real error = std::max(Ham_error_history[num_steps - 1],
+                          Mom_error_history[num_steps - 1]);
+    Real error_old = std::max(Ham_error_history[num_steps - 2],
+                              Mom_error_history[num_steps - 2]);
+    Real new_tolerance = max_tolerance;
+    if (error_old > 0.0)
+    {
+        new_tolerance = gamma * pow(error / error_old, alpha);
+    }
+
+    // safeguard against the tolerance dropping too quickly
+    Real safeguard = gamma * pow(linear_tolerance, alpha);
+    if (safeguard > 0.1)
+    {
+        new_tolerance = std::max(new_tolerance, safeguard);
+    }
+
+    linear_tolerance =
+        std::min(std::max(new_tolerance, min_tolerance), max_tolerance);
+    return linear_tolerance;
+}
+
+template <typename method_t, typename matter_t>
+void GRSolver<method_t, matter_t>::print_NL_status(
+    const NL_status_t a_status) const
+{
+    switch (a_status)
+    {
+    case NL_ERROR_TOLERANCE:
+        pout() << "Converged! Errors are below NL_Ham_tolerance and "
+                  "NL_Mom_tolerance"
+               << endl;
+        break;
+    case NL_RELATIVE_TOLERANCE:
+        pout() << "Converged! Errors reduced by NL_relative_tolerance" << endl;
+        break;
+    case NL_UPDATE_TOLERANCE:
+        pout() << "Converged! Linear update is below NL_update_tolerance"
+               << endl;
+        break;
+    case NL_STAGNATED:
+        pout() << "Stopped: errors have stagnated over the last "
+               << params.base_params.NL_stagnation_iter << " steps" << endl;
+        break;
+    default:
+        pout() << "Finished: reached max_NL_iterations" << endl;
+    }
 }
 
 template <typename method_t, typename matter_t>
@@ -213,6 +695,8 @@ void GRSolver<method_t, matter_t>::create_vars()
     {
         multigrid_vars[ilev] = new LevelData<FArrayBox>(
             grids->grids_data[ilev], NUM_MULTIGRID_VARS, ghosts);
+        bh_vars[ilev] = new LevelData<FArrayBox>(grids->grids_data[ilev],
+                                                 NUM_BH_VARS, ghosts);
 
         constraint_vars[ilev] = new LevelData<FArrayBox>(
             grids->grids_data[ilev], NUM_CONSTRAINT_VARS, ghosts);
@@ -233,6 +717,8 @@ void GRSolver<method_t, matter_t>::create_vars()
         RealVect dxLevel = grids->vectDx[ilev];
 
         method->initialise_method_vars(*multigrid_vars[ilev], dxLevel);
+        psi_and_Aij_functions->set_bowenyork_vars(
+            *bh_vars[ilev], dxLevel, params.grid_params.center);
         matter->initialise_matter_vars(*multigrid_vars[ilev], dxLevel);
 
         method->initialise_constraint_vars(*constraint_vars[ilev], dxLevel);
@@ -243,6 +729,124 @@ void GRSolver<method_t, matter_t>::create_vars()
         diagnostics->initialise_diagnostic_vars(*diagnostic_vars[ilev],
                                                 dxLevel);
     }
+
+    // overwrite the analytic matter fields with those in the input file
+    // (on restart they are read from the checkpoint instead)
+    if (params.base_params.readin_matter_data && !params.base_params.restart)
+    {
+        std::vector<int> matter_comps;
+        for (int icomp = NUM_METRIC_VARS; icomp < NUM_MULTIGRID_VARS; icomp++)
+        {
+            matter_comps.push_back(icomp);
+        }
+        grids->read_input_vars(multigrid_vars,
+                               params.base_params.input_filename,
+                               params.base_params.input_matter_names,
+                               matter_comps);
+    }
+}
+
+template <typename method_t, typename matter_t>
+void GRSolver<method_t, matter_t>::write_checkpoint(const int NL_iter) const
+{
+#ifdef CH_USE_HDF5
+    CH_TIME("GRSolver::write_checkpoint");
+
+    char suffix[30];
+    sprintf(suffix, "%06d.%dd.hdf5", NL_iter, SpaceDim);
+    std::string filename = params.base_params.checkpoint_prefix + suffix;
+    pout() << "Writing checkpoint " << filename << endl;
+
+    // HDF5 is not thread safe, so the diagnostic files must be finished
+    if (output_writer)
+    {
+        output_writer->wait();
+    }
+
+    HDF5Handle handle(filename, HDF5Handle::CREATE);
+    HDF5HeaderData header;
+    header.m_int["num_levels"] = numLevels;
+    header.m_int["num_multigrid_vars"] = NUM_MULTIGRID_VARS;
+    header.m_int["num_constraint_vars"] = NUM_CONSTRAINT_VARS;
+    header.m_int["NL_iter"] = NL_iter;
+    header.m_real["linear_tolerance"] = linear_tolerance;
+    const int num_steps = Ham_error_history.size();
+    header.m_int["num_error_steps"] = num_steps;
+    for (int istep = 0; istep < num_steps; istep++)
+    {
+        char name[30];
+        sprintf(name, "Ham_error_%d", istep);
+        header.m_real[name] = Ham_error_history[istep];
+        sprintf(name, "Mom_error_%d", istep);
+        header.m_real[name] = Mom_error_history[istep];
+    }
+    header.writeToFile(handle);
+
+    // only the valid cells are written, the ghosts are filled on restart
+    for (int ilev = 0; ilev < numLevels; ilev++)
+    {
+        handle.setGroupToLevel(ilev);
+        write(handle, grids->grids_data[ilev]);
+        write(handle, *multigrid_vars[ilev], "multigrid_vars", IntVect::Zero);
+        write(handle, *constraint_vars[ilev], "constraint_vars",
+              IntVect::Zero);
+    }
+    handle.close();
+#endif
+}
+
+template <typename method_t, typename matter_t>
+void GRSolver<method_t, matter_t>::read_checkpoint()
+{
+#ifdef CH_USE_HDF5
+    const std::string &filename = params.base_params.restart_file;
+    pout() << "Restarting from checkpoint " << filename << endl;
+
+    HDF5Handle handle(filename, HDF5Handle::OPEN_RDONLY);
+    HDF5HeaderData header;
+    header.readFromFile(handle);
+    if (header.m_int["num_multigrid_vars"] != NUM_MULTIGRID_VARS ||
+        header.m_int["num_constraint_vars"] != NUM_CONSTRAINT_VARS)
+    {
+        MayDay::Error("restart_file was written with different variables");
+    }
+
+    first_NL_iter = header.m_int["NL_iter"];
+    linear_tolerance = header.m_real["linear_tolerance"];
+    const int num_steps = header.m_int["num_error_steps"];
+    Ham_error_history.resize(num_steps);
+    Mom_error_history.resize(num_steps);
+    for (int istep = 0; istep < num_steps; istep++)
+    {
+        char name[30];
+        sprintf(name, "Ham_error_%d", istep);
+        Ham_error_history[istep] = header.m_real[name];
+        sprintf(name, "Mom_error_%d", istep);
+        Mom_error_history[istep] = header.m_real[name];
+    }
+    if (num_steps > 0)
+    {
+        Ham_error = Ham_error_history.back();
+        Mom_error = Mom_error_history.back();
+    }
+
+    // the grids were already read from the same file by read_grids
+    for (int ilev = 0; ilev < numLevels; ilev++)
+    {
+        handle.setGroupToLevel(ilev);
+        bool redefine_data = false;
+        if (read<FArrayBox>(handle, *multigrid_vars[ilev], "multigrid_vars",
+                            grids->grids_data[ilev], Interval(),
+                            redefine_data) != 0 ||
+            read<FArrayBox>(handle, *constraint_vars[ilev], "constraint_vars",
+                            grids->grids_data[ilev], Interval(),
+                            redefine_data) != 0)
+        {
+            MayDay::Error("failed to read the data in restart_file");
+        }
+    }
+    handle.close();
+#endif
 }
 
 template <class method_t, class matter_t>
@@ -250,6 +854,9 @@ GRSolver<method_t, matter_t>::~GRSolver()
 {
 
     delete grids;
+    delete anderson_mixing;
+    delete fft_solver;
+    delete output_writer;
     delete psi_and_Aij_functions;
     delete diagnostics;
     delete tagging_criterion;
@@ -259,6 +866,7 @@ GRSolver<method_t, matter_t>::~GRSolver()
     for (int ilev = 0; ilev < numLevels; ilev++)
     {
         delete multigrid_vars[ilev];
+        delete bh_vars[ilev];
         delete constraint_vars[ilev];
         delete rhs[ilev];
         delete diagnostic_vars[ilev];
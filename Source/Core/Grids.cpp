@@ -16,7 +16,9 @@
 #include "ProblemDomain.H"
 #include "REAL.H"
 #include "RealVect.H"
+#include "SPMD.H"
 #include "VariableCoeffPoissonOperatorFactory.H"
+#include <cmath>
 
 void Grids::read_params(GRParmParse &pp, params_t &m_grid_params)
 {
@@ -135,28 +137,105 @@ void Grids::read_params(GRParmParse &pp, params_t &m_grid_params)
 
 void Grids::read_grids(std::string input_filename)
 {
+    reset_cached_objects();
+
+    set_domains_and_dx(vectDomain, vectDx);
+
+#ifdef CH_USE_HDF5
+
+    HDF5Handle handle(input_filename, HDF5Handle::OPEN_RDONLY);
+    HDF5HeaderData header;
+    header.readFromFile(handle);
+    if (header.m_int["num_levels"] < m_grid_params.numLevels)
+    {
+        MayDay::Error("input_filename has fewer levels than max_level + 1");
+    }
+
+    // only the boxes are read here, the data is read by read_input_vars
+    // once the variables are defined on these grids
+    grids_data.resize(m_grid_params.numLevels);
+    for (int ilev = 0; ilev < m_grid_params.numLevels; ilev++)
+    {
+        handle.setGroupToLevel(ilev);
+        Vector<Box> boxes;
+        if (read(handle, boxes) != 0)
+        {
+            MayDay::Error("failed to read the boxes in input_filename");
+        }
+        Vector<int> procs;
+        LoadBalance(procs, boxes);
+        grids_data[ilev].define(boxes, procs, vectDomain[ilev]);
+    }
+    handle.close();
+#endif
+}
+
+void Grids::read_input_vars(Vector<LevelData<FArrayBox> *> vars,
+                            std::string input_filename,
+                            const std::vector<std::string> &a_names,
+                            const std::vector<int> &a_comps)
+{
+    CH_assert(a_names.size() == a_comps.size());
+
 #ifdef CH_USE_HDF5
 
-    // set up a temp data structure for the source data
-    Vector<LevelData<FArrayBox> *> temp_data;
-    Vector<string> variable_names;
-    int temp_num_levels;
-    Real dx, dt, time;
-    Box temp_domain_box;
-    Vector<int> temp_ref_ratio;
-
-    // update directly the input grids
-    ReadAMRHierarchyHDF5(input_filename, grids_data, temp_data, variable_names,
-                         temp_domain_box, dx, dt, time, temp_ref_ratio,
-                         temp_num_levels);
-
-    int max_temp_level = temp_data.size();
-    // clean up temporary storage
-    for (int level = 0; level < max_temp_level; level++)
+    HDF5Handle handle(input_filename, HDF5Handle::OPEN_RDONLY);
+    HDF5HeaderData header;
+    header.readFromFile(handle);
+
+    // find the components of the file by name
+    const int num_vars = a_names.size();
+    std::vector<int> file_comps(num_vars, -1);
+    const int num_file_comps = header.m_int["num_components"];
+    for (int icomp = 0; icomp < num_file_comps; icomp++)
+    {
+        char comp_str[30];
+        sprintf(comp_str, "component_%d", icomp);
+        for (int ivar = 0; ivar < num_vars; ivar++)
+        {
+            if (header.m_string[comp_str] == a_names[ivar])
+            {
+                file_comps[ivar] = icomp;
+            }
+        }
+    }
+    for (int ivar = 0; ivar < num_vars; ivar++)
+    {
+        if (file_comps[ivar] < 0)
+        {
+            std::string message =
+                "variable " + a_names[ivar] + " not found in input_filename";
+            MayDay::Error(message.c_str());
+        }
+    }
+
+    for (int ilev = 0; ilev < m_grid_params.numLevels; ilev++)
     {
-        delete temp_data[level];
-        temp_data[level] = NULL;
+        handle.setGroupToLevel(ilev);
+        for (int ivar = 0; ivar < num_vars; ivar++)
+        {
+            LevelData<FArrayBox> comp_data;
+            Interval file_interval(file_comps[ivar], file_comps[ivar]);
+            if (read<FArrayBox>(handle, comp_data, "data", grids_data[ilev],
+                                file_interval) != 0)
+            {
+                MayDay::Error("failed to read the data in input_filename");
+            }
+
+            // the ghosts are filled later from the valid cells
+            DataIterator dit = comp_data.dataIterator();
+            int nbox = dit.size();
+#pragma omp parallel for default(shared)
+            for (int ibox = 0; ibox < nbox; ++ibox)
+            {
+                DataIndex dind = dit[ibox];
+                const Box &box = grids_data[ilev][dind];
+                (*vars[ilev])[dind].copy(comp_data[dind], box, 0, box,
+                                         a_comps[ivar], 1);
+            }
+        }
     }
+    handle.close();
 #endif
 }
 
@@ -165,61 +244,73 @@ void Grids::define_operator(MultilevelLinearOp<FArrayBox> &mlOp,
                             Vector<RefCountedPtr<LevelData<FArrayBox>>> &bCoef,
                             const Real &a_alpha, const Real &a_beta)
 {
-    RefCountedPtr<AMRLevelOpFactory<LevelData<FArrayBox>>> opFactory =
-        RefCountedPtr<AMRLevelOpFactory<LevelData<FArrayBox>>>(
+    // The grids do not change during the solve and the factory shares the
+    // coefficient data, so the new aCoef and bCoef are picked up when the
+    // operators (and their coarsened MG coefficients) are created below
+    if (m_opFactory.isNull())
+    {
+        m_opFactory = RefCountedPtr<AMRLevelOpFactory<LevelData<FArrayBox>>>(
             defineOperatorFactory(grids_data, vectDomain, aCoef, bCoef,
                                   m_grid_params, a_alpha, a_beta));
+    }
+
+    // the operators of a previous define are deleted by mlOp.define
+    get_operator_factory().clearOperators();
 
     int lBase = 0;
     mlOp.define(grids_data, m_grid_params.refRatio, vectDomain, vectDx,
-                opFactory, lBase);
+                m_opFactory, lBase);
+}
+
+void Grids::update_operator_coefficients()
+{
+    CH_assert(!m_opFactory.isNull());
+    get_operator_factory().updateCoefficients();
+}
+
+VariableCoeffPoissonOperatorFactory &Grids::get_operator_factory()
+{
+    VariableCoeffPoissonOperatorFactory *factory =
+        dynamic_cast<VariableCoeffPoissonOperatorFactory *>(&(*m_opFactory));
+    CH_assert(factory != NULL);
+    return *factory;
 }
 
 void Grids::update_psi0(Vector<LevelData<FArrayBox> *> multigrid_vars,
                         Vector<LevelData<FArrayBox> *> constraint_vars,
                         bool deactivate_zero_mode)
 {
+    if (!m_ghost_filling_defined)
+    {
+        define_ghost_filling();
+    }
+
     for (int ilev = 0; ilev < m_grid_params.numLevels; ilev++)
     {
-        IntVect ghosts = m_grid_params.num_ghosts * IntVect::Unit;
         // For interlevel ghosts in constraint_vars
         if (ilev > 0)
         {
             // Fill using 4th order method which fills corner ghosts
-            int num_ghosts = 1;
-            FourthOrderCFInterp m_patcher;
-            m_patcher.define(grids_data[ilev], grids_data[ilev - 1],
-                             NUM_CONSTRAINT_VARS, vectDomain[ilev - 1],
-                             m_grid_params.refRatio[ilev], num_ghosts);
-            m_patcher.coarseFineInterp(*constraint_vars[ilev],
-                                       *constraint_vars[ilev - 1], 0, 0,
-                                       NUM_CONSTRAINT_VARS);
+            m_fourthOrderCFI[ilev]->coarseFineInterp(
+                *constraint_vars[ilev], *constraint_vars[ilev - 1], 0, 0,
+                NUM_CONSTRAINT_VARS);
         }
 
-        // For intralevel ghosts - this is done below
-        // but need the exchange copier object to do this
-        BoundaryConditions solver_boundaries;
-        solver_boundaries.define(vectDx[ilev][0], m_grid_params.boundary_params,
-                                 vectDomain[ilev], m_grid_params.num_ghosts);
-        // For intralevel ghosts
-        DisjointBoxLayout grown_grids;
-        solver_boundaries.expand_grids_to_boundaries(grown_grids,
-                                                     grids_data[ilev]);
-        Copier exchange_copier;
-        exchange_copier.exchangeDefine(grown_grids, ghosts);
-
         // now the update
 
         // first exchange ghost cells for constraint_vars so they are filled
         // with the correct values
         constraint_vars[ilev]->exchange(constraint_vars[ilev]->interval(),
-                                        exchange_copier);
+                                        m_exchange_copiers[ilev]);
 
         DataIterator dit = multigrid_vars[ilev]->dataIterator();
-        for (dit.begin(); dit.ok(); ++dit)
+        int nbox = dit.size();
+#pragma omp parallel for default(shared)
+        for (int ibox = 0; ibox < nbox; ++ibox)
         {
-            FArrayBox &multigrid_vars_box = (*multigrid_vars[ilev])[dit()];
-            FArrayBox &constraint_vars_box = (*constraint_vars[ilev])[dit()];
+            DataIndex dind = dit[ibox];
+            FArrayBox &multigrid_vars_box = (*multigrid_vars[ilev])[dind];
+            FArrayBox &constraint_vars_box = (*constraint_vars[ilev])[dind];
 
             Box ghosted_box = multigrid_vars_box.box();
             BoxIterator bit(ghosted_box);
@@ -257,55 +348,261 @@ void Grids::update_psi0(Vector<LevelData<FArrayBox> *> multigrid_vars,
     }
 }
 
+void Grids::remove_mean(Vector<LevelData<FArrayBox> *> vars,
+                        const Interval &a_interval)
+{
+    std::vector<reduction_t> components;
+    for (int icomp = a_interval.begin(); icomp <= a_interval.end(); icomp++)
+    {
+        components.push_back({vars, Interval(icomp, icomp), false});
+    }
+    remove_mean(components);
+}
+
+void Grids::remove_mean(const std::vector<reduction_t> &a_components)
+{
+    if (a_components.empty())
+    {
+        return;
+    }
+
+    Real volume = 1.0;
+    for (int idir = 0; idir < SpaceDim; idir++)
+    {
+        volume *= m_grid_params.nCells[idir] * m_grid_params.coarsestDx;
+    }
+
+    std::vector<Real> sums;
+    compute_reductions(sums, a_components);
+
+    for (int ired = 0; ired < a_components.size(); ired++)
+    {
+        const reduction_t &component = a_components[ired];
+        CH_assert(!component.is_norm && component.interval.size() == 1);
+        const int icomp = component.interval.begin();
+        const Real mean = sums[ired] / volume;
+
+        // shift the ghosts too, so they stay consistent with the interior
+        for (int ilev = 0; ilev < m_grid_params.numLevels; ilev++)
+        {
+            DataIterator dit = component.vars[ilev]->dataIterator();
+            int nbox = dit.size();
+#pragma omp parallel for default(shared)
+            for (int ibox = 0; ibox < nbox; ++ibox)
+            {
+                DataIndex dind = dit[ibox];
+                (*component.vars[ilev])[dind].plus(-mean, icomp);
+            }
+        }
+    }
+}
+
+void Grids::compute_reductions(std::vector<Real> &a_results,
+                               const std::vector<reduction_t> &a_reductions)
+{
+    if (!m_reduction_masks_defined)
+    {
+        define_reduction_masks();
+    }
+
+    const int num_reductions = a_reductions.size();
+    std::vector<Real> local_results(num_reductions, 0.0);
+    for (int ilev = 0; ilev < m_grid_params.numLevels; ilev++)
+    {
+        const Real cell_volume = pow(vectDx[ilev][0], SpaceDim);
+        const LevelData<FArrayBox> &mask = *m_reduction_masks[ilev];
+
+        // the partial sums of each box are added up in box order below, so
+        // that the result does not depend on the number of threads
+        DataIterator dit = mask.dataIterator();
+        int nbox = dit.size();
+        std::vector<Real> box_results((size_t)nbox * num_reductions, 0.0);
+#pragma omp parallel for default(shared)
+        for (int ibox = 0; ibox < nbox; ++ibox)
+        {
+            DataIndex dind = dit[ibox];
+            const FArrayBox &mask_box = mask[dind];
+            Real *results = &box_results[(size_t)ibox * num_reductions];
+            for (int ired = 0; ired < num_reductions; ired++)
+            {
+                const reduction_t &reduction = a_reductions[ired];
+                const FArrayBox &vars_box = (*reduction.vars[ilev])[dind];
+                for (int icomp = reduction.interval.begin();
+                     icomp <= reduction.interval.end(); icomp++)
+                {
+                    BoxIterator bit(grids_data[ilev][dind]);
+                    for (bit.begin(); bit.ok(); ++bit)
+                    {
+                        IntVect iv = bit();
+                        Real value = vars_box(iv, icomp);
+                        if (reduction.is_norm)
+                        {
+                            value *= value;
+                        }
+                        results[ired] += mask_box(iv, 0) * value;
+                    }
+                }
+            }
+        }
+
+        for (int ibox = 0; ibox < nbox; ++ibox)
+        {
+            for (int ired = 0; ired < num_reductions; ired++)
+            {
+                local_results[ired] +=
+                    cell_volume *
+                    box_results[(size_t)ibox * num_reductions + ired];
+            }
+        }
+    }
+
+    a_results.resize(num_reductions);
+#ifdef CH_MPI
+    MPI_Allreduce(local_results.data(), a_results.data(), num_reductions,
+                  MPI_CH_REAL, MPI_SUM, Chombo_MPI::comm);
+#else
+    a_results = local_results;
+#endif
+
+    for (int ired = 0; ired < num_reductions; ired++)
+    {
+        if (a_reductions[ired].is_norm)
+        {
+            a_results[ired] = sqrt(a_results[ired]);
+        }
+    }
+}
+
+void Grids::define_reduction_masks()
+{
+    const int numLevels = m_grid_params.numLevels;
+    m_reduction_masks.resize(numLevels);
+    for (int ilev = 0; ilev < numLevels; ilev++)
+    {
+        m_reduction_masks[ilev] = RefCountedPtr<LevelData<FArrayBox>>(
+            new LevelData<FArrayBox>(grids_data[ilev], 1));
+        LevelData<FArrayBox> &mask = *m_reduction_masks[ilev];
+        mask.setVal(1.0);
+        if (ilev == numLevels - 1)
+        {
+            continue;
+        }
+
+        DisjointBoxLayout covered_grids;
+        coarsen(covered_grids, grids_data[ilev + 1],
+                m_grid_params.refRatio[ilev]);
+        for (DataIterator dit = mask.dataIterator(); dit.ok(); ++dit)
+        {
+            FArrayBox &mask_box = mask[dit];
+            for (LayoutIterator lit = covered_grids.layoutIterator();
+                 lit.ok(); ++lit)
+            {
+                Box covered_box = covered_grids[lit];
+                covered_box &= mask_box.box();
+                if (!covered_box.isEmpty())
+                {
+                    mask_box.setVal(0.0, covered_box, 0);
+                }
+            }
+        }
+    }
+    m_reduction_masks_defined = true;
+}
+
 void Grids::fill_ghosts_correct_coarse(
     Vector<LevelData<FArrayBox> *> multigrid_vars, bool filling_solver_vars)
 {
-    for (int ilev = 0; ilev < m_grid_params.numLevels; ilev++)
+    if (!m_ghost_filling_defined)
     {
-        // fill the boundary cells and ghosts
-        BoundaryConditions solver_boundaries;
-        solver_boundaries.define(vectDx[ilev][0], m_grid_params.boundary_params,
-                                 vectDomain[ilev], m_grid_params.num_ghosts);
+        define_ghost_filling();
+    }
 
+    for (int ilev = 0; ilev < m_grid_params.numLevels; ilev++)
+    {
         const Interval &a_comps = filling_solver_vars
                                       ? Interval(c_psi_reg, c_U_0)
                                       : Interval(0, NUM_MULTIGRID_VARS - 1);
 
+        // fill the boundary cells and ghosts
         // this will populate the multigrid boundaries according to the BCs
         // in particular it will fill cells for Aij, and updated K
-        solver_boundaries.fill_multigrid_boundaries(
+        m_solver_boundaries[ilev].fill_multigrid_boundaries(
             Side::Lo, *multigrid_vars[ilev], a_comps,
             filling_solver_vars); //, Interval(c_K_0, c_A33_0));
-        solver_boundaries.fill_multigrid_boundaries(
+        m_solver_boundaries[ilev].fill_multigrid_boundaries(
             Side::Hi, *multigrid_vars[ilev], a_comps,
             filling_solver_vars); //, Interval(c_K_0, c_A33_0));
 
-        // To define an exchange copier to cover the outer ghosts
-        DisjointBoxLayout grown_grids;
-        solver_boundaries.expand_grids_to_boundaries(grown_grids,
-                                                     grids_data[ilev]);
-
         // Fill the interlevel ghosts from a coarser level
         if (ilev > 0)
         {
-            QuadCFInterp quadCFI(grids_data[ilev], &grids_data[ilev - 1],
-                                 vectDx[ilev][0], m_grid_params.refRatio[ilev],
-                                 NUM_MULTIGRID_VARS, vectDomain[ilev]);
-            quadCFI.coarseFineInterp(*multigrid_vars[ilev],
-                                     *multigrid_vars[ilev - 1]);
+            m_quadCFI[ilev]->coarseFineInterp(*multigrid_vars[ilev],
+                                              *multigrid_vars[ilev - 1]);
         }
 
         // exchange the interior ghosts
-        IntVect ghosts = m_grid_params.num_ghosts * IntVect::Unit;
-        Copier exchange_copier;
-        exchange_copier.exchangeDefine(grown_grids, ghosts);
         multigrid_vars[ilev]->exchange(multigrid_vars[ilev]->interval(),
-                                       exchange_copier);
+                                       m_exchange_copiers[ilev]);
     }
 }
 
+void Grids::define_ghost_filling()
+{
+    int numLevels = m_grid_params.numLevels;
+    m_solver_boundaries.resize(numLevels);
+    m_exchange_copiers.resize(numLevels);
+    m_quadCFI.resize(numLevels);
+    m_fourthOrderCFI.resize(numLevels);
+
+    IntVect ghosts = m_grid_params.num_ghosts * IntVect::Unit;
+    for (int ilev = 0; ilev < numLevels; ilev++)
+    {
+        m_solver_boundaries[ilev].define(
+            vectDx[ilev][0], m_grid_params.boundary_params, vectDomain[ilev],
+            m_grid_params.num_ghosts);
+
+        // To define an exchange copier to cover the outer ghosts
+        DisjointBoxLayout grown_grids;
+        m_solver_boundaries[ilev].expand_grids_to_boundaries(grown_grids,
+                                                             grids_data[ilev]);
+        m_exchange_copiers[ilev].exchangeDefine(grown_grids, ghosts);
+
+        if (ilev > 0)
+        {
+            m_quadCFI[ilev] = RefCountedPtr<QuadCFInterp>(new QuadCFInterp(
+                grids_data[ilev], &grids_data[ilev - 1], vectDx[ilev][0],
+                m_grid_params.refRatio[ilev], NUM_MULTIGRID_VARS,
+                vectDomain[ilev]));
+
+            // only the first ghost of constraint_vars is needed
+            int num_ghosts = 1;
+            m_fourthOrderCFI[ilev] =
+                RefCountedPtr<FourthOrderCFInterp>(new FourthOrderCFInterp);
+            m_fourthOrderCFI[ilev]->define(
+                grids_data[ilev], grids_data[ilev - 1], NUM_CONSTRAINT_VARS,
+                vectDomain[ilev - 1], m_grid_params.refRatio[ilev],
+                num_ghosts);
+        }
+    }
+    m_ghost_filling_defined = true;
+}
+
+void Grids::reset_cached_objects()
+{
+    m_ghost_filling_defined = false;
+    m_solver_boundaries.clear();
+    m_exchange_copiers.clear();
+    m_quadCFI.clear();
+    m_fourthOrderCFI.clear();
+    m_reduction_masks_defined = false;
+    m_reduction_masks.clear();
+    m_opFactory = RefCountedPtr<AMRLevelOpFactory<LevelData<FArrayBox>>>();
+}
+
 void Grids::set_grids()
 {
+    reset_cached_objects();
+
     set_domains_and_dx(vectDomain, vectDx);
 
     int numlevels = m_grid_params.numLevels;
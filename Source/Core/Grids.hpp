@@ -8,17 +8,23 @@
 
 #include "BoundaryConditions.hpp"
 #include "CoarseAverage.H"
+#include "Copier.H"
 #include "FilesystemTools.hpp"
+#include "FourthOrderCFInterp.H"
 #include "GRParmParse.hpp"
 #include "IntVect.H"
 #include "IntVectSet.H"
 #include "MultilevelLinearOp.H"
 #include "ProblemDomain.H"
+#include "QuadCFInterp.H"
 #include "REAL.H"
 #include "RealVect.H"
 #include "TaggingCriterion.hpp"
 #include "computeNorm.H"
 #include "computeSum.H"
+#include <vector>
+
+class VariableCoeffPoissonOperatorFactory;
 
 class Grids
 {
@@ -55,7 +61,9 @@ class Grids
     Grids(params_t a_grid_params, TaggingCriterion *a_tagging_criterion,
           bool a_readin_matter_data)
         : m_grid_params(a_grid_params), tagging_criterion(a_tagging_criterion),
-          readin_matter_data(a_readin_matter_data){};
+          readin_matter_data(a_readin_matter_data),
+          m_ghost_filling_defined(false),
+          m_reduction_masks_defined(false){};
 
     // get location:
     // This takes an IntVect and writes the physical coordinates to a RealVect
@@ -63,17 +71,36 @@ class Grids
                         const RealVect &a_dx,
                         const std::array<double, SpaceDim> center);
 
+    // Only reads the box layouts of the levels in input_filename
     void read_grids(std::string input_filename);
 
+    // Overwrites the components a_comps of vars with the components named
+    // a_names in input_filename, which must have the same grids. One
+    // component of one level is read at a time and each rank only reads
+    // the boxes it owns.
+    void read_input_vars(Vector<LevelData<FArrayBox> *> vars,
+                         std::string input_filename,
+                         const std::vector<std::string> &a_names,
+                         const std::vector<int> &a_comps);
+
     void set_grids();
 
     static void read_params(GRParmParse &pp, params_t &grid_params);
 
+    // The operator factory (with its exchange copiers and CF regions) is
+    // only built on the first call and reused afterwards. It holds on to
+    // aCoef and bCoef, so these must be the same objects on every call,
+    // but their values can change between calls.
     void define_operator(MultilevelLinearOp<FArrayBox> &mlOp,
                          Vector<RefCountedPtr<LevelData<FArrayBox>>> &aCoef,
                          Vector<RefCountedPtr<LevelData<FArrayBox>>> &bCoef,
                          const Real &a_alpha, const Real &a_beta);
 
+    // Passes the new values of aCoef and bCoef on to the operators of the
+    // mlOp last defined by define_operator, rather than defining it again,
+    // which would rebuild the whole multigrid hierarchy
+    void update_operator_coefficients();
+
     void
     fill_ghosts_correct_coarse(Vector<LevelData<FArrayBox> *> multigrid_vars,
                                bool filling_solver_vars);
@@ -82,6 +109,12 @@ class Grids
                      Vector<LevelData<FArrayBox> *> constraint_vars,
                      bool deactivate_zero_mode);
 
+
+    // Drops the cached ghost filling objects, reduction masks and operator
+    // factory, so that they are rebuilt for the current grids on the next
+    // use. Called whenever the grids are (re)defined.
+    void reset_cached_objects();
+
     params_t m_grid_params;
 
     TaggingCriterion *tagging_criterion;
@@ -106,6 +139,30 @@ class Grids
                            m_grid_params.coarsestDx, a_interval);
     }
 
+    // One entry of a batch of global reductions: the volume weighted sum
+    // or the L2 norm of the components in interval of vars
+    struct reduction_t
+    {
+        Vector<LevelData<FArrayBox> *> vars;
+        Interval interval;
+        bool is_norm;
+    };
+
+    // Computes a batch of sums and norms (the same values as compute_sum
+    // and compute_norm) in a single traversal of the levels and a single
+    // all-reduce, rather than one of each per reduction
+    void compute_reductions(std::vector<Real> &a_results,
+                            const std::vector<reduction_t> &a_reductions);
+
+    // Subtracts the volume weighted mean over the composite grid from each
+    // component in a_interval, i.e. projects out the constant mode
+    void remove_mean(Vector<LevelData<FArrayBox> *> vars,
+                     const Interval &a_interval);
+
+    // The same for a batch of single component sums, which are all
+    // computed with one compute_reductions
+    void remove_mean(const std::vector<reduction_t> &a_components);
+
     Real compute_max(Vector<LevelData<FArrayBox> *> vars,
                      const Interval &a_interval)
     {
@@ -115,6 +172,28 @@ class Grids
   private:
     bool readin_matter_data;
 
+    RefCountedPtr<AMRLevelOpFactory<LevelData<FArrayBox>>> m_opFactory;
+
+    VariableCoeffPoissonOperatorFactory &get_operator_factory();
+
+    // The objects used to fill the ghost cells only depend on the grids, so
+    // they are built once per level by define_ghost_filling and reused by
+    // fill_ghosts_correct_coarse and update_psi0
+    bool m_ghost_filling_defined;
+    Vector<BoundaryConditions> m_solver_boundaries;
+    Vector<Copier> m_exchange_copiers;
+    Vector<RefCountedPtr<QuadCFInterp>> m_quadCFI;
+    Vector<RefCountedPtr<FourthOrderCFInterp>> m_fourthOrderCFI;
+
+    void define_ghost_filling();
+
+    // Masks which are 0 on the cells covered by the next finer level and
+    // 1 elsewhere, built once by define_reduction_masks
+    bool m_reduction_masks_defined;
+    Vector<RefCountedPtr<LevelData<FArrayBox>>> m_reduction_masks;
+
+    void define_reduction_masks();
+
     void set_domains_and_dx(Vector<ProblemDomain> &vectDomain,
                             Vector<RealVect> &vectDx);
 
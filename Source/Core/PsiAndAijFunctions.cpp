@@ -4,6 +4,7 @@
  */
 
 #include "PsiAndAijFunctions.hpp"
+#include "Grids.hpp"
 #include "REAL.H"
 #include "RealVect.H"
 #include "Tensor.hpp"
@@ -156,26 +157,85 @@ void PsiAndAijFunctions::compute_bowenyork_Aij(
     }
 }
 
+void PsiAndAijFunctions::set_bowenyork_vars(
+    LevelData<FArrayBox> &a_bh_vars, const RealVect &a_dx,
+    const std::array<double, SpaceDim> &a_center)
+{
+    CH_assert(a_bh_vars.nComp() == NUM_BH_VARS);
+
+    DataIterator dit = a_bh_vars.dataIterator();
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
+    {
+        DataIndex dind = dit[ibox];
+        FArrayBox &bh_vars_box = a_bh_vars[dind];
+        Box ghosted_box = bh_vars_box.box();
+        BoxIterator bit(ghosted_box);
+        for (bit.begin(); bit.ok(); ++bit)
+        {
+            // work out location on the grid
+            IntVect iv = bit();
+            RealVect loc;
+            Grids::get_loc(loc, iv, a_dx, a_center);
+
+            bh_vars_box(iv, c_psi_bh) = compute_bowenyork_psi(loc);
+
+            Tensor<2, Real> Aij_bh;
+            compute_bowenyork_Aij(Aij_bh, loc);
+            bh_vars_box(iv, c_A11_bh) = Aij_bh[0][0];
+            bh_vars_box(iv, c_A12_bh) = Aij_bh[0][1];
+            bh_vars_box(iv, c_A13_bh) = Aij_bh[0][2];
+            bh_vars_box(iv, c_A22_bh) = Aij_bh[1][1];
+            bh_vars_box(iv, c_A23_bh) = Aij_bh[1][2];
+            bh_vars_box(iv, c_A33_bh) = Aij_bh[2][2];
+        }
+    }
+}
+
+void PsiAndAijFunctions::get_bowenyork_Aij(Tensor<2, Real> &Aij,
+                                           const FArrayBox &bh_vars_box,
+                                           const IntVect &iv)
+{
+    Aij[0][0] = bh_vars_box(iv, c_A11_bh);
+    Aij[0][1] = bh_vars_box(iv, c_A12_bh);
+    Aij[0][2] = bh_vars_box(iv, c_A13_bh);
+    Aij[1][1] = bh_vars_box(iv, c_A22_bh);
+    Aij[1][2] = bh_vars_box(iv, c_A23_bh);
+    Aij[2][2] = bh_vars_box(iv, c_A33_bh);
+    Aij[1][0] = Aij[0][1];
+    Aij[2][0] = Aij[0][2];
+    Aij[2][1] = Aij[1][2];
+}
+
 // The part of Aij excluding the Brill Lindquist BH Aij
 // Using ansatz in B&S Appendix B Eq B.5
 void PsiAndAijFunctions::compute_ctt_Aij(Tensor<2, Real> &Aij,
                                          const FArrayBox &multigrid_vars_box,
                                          const IntVect &iv,
-                                         const RealVect &a_dx,
+                                         const DerivativeOperators &a_derivs,
                                          const RealVect &loc) const
 {
-    DerivativeOperators derivs(a_dx);
-
     // get the derivs
     Tensor<2, Real, SpaceDim> d2_U;
-    derivs.get_d2(d2_U, iv, multigrid_vars_box, c_U_0);
+    a_derivs.get_d2(d2_U, iv, multigrid_vars_box, c_U_0);
     Tensor<2, Real, SpaceDim> d1_Vi;
-    derivs.get_d1_vector(d1_Vi, iv, multigrid_vars_box,
-                         Interval(c_V1_0, c_V3_0));
+    a_derivs.get_d1_vector(d1_Vi, iv, multigrid_vars_box,
+                           Interval(c_V1_0, c_V3_0));
     Tensor<3, Real, SpaceDim> d2_Vi;
-    derivs.get_d2_vector(d2_Vi, iv, multigrid_vars_box,
-                         Interval(c_V1_0, c_V3_0));
+    a_derivs.get_d2_vector(d2_Vi, iv, multigrid_vars_box,
+                           Interval(c_V1_0, c_V3_0));
 
+    compute_ctt_Aij(Aij, d1_Vi, d2_Vi, d2_U, loc);
+}
+
+// As above but using derivatives that have already been calculated
+void PsiAndAijFunctions::compute_ctt_Aij(Tensor<2, Real> &Aij,
+                                         const Tensor<2, Real, SpaceDim> &d1_Vi,
+                                         const Tensor<3, Real, SpaceDim> &d2_Vi,
+                                         const Tensor<2, Real, SpaceDim> &d2_U,
+                                         const RealVect &loc) const
+{
     // Periodic: Use ansatz B.3 in B&S (p547)
     // Non-periodic: Compact ansatz B.7 in B&S (p547)
     Real trace = 0.0;
@@ -6,10 +6,12 @@
 #ifndef PSIANDAIJFUNCTIONS_HPP_
 #define PSIANDAIJFUNCTIONS_HPP_
 
+#include "BHVariables.hpp"
 #include "DerivativeOperators.hpp"
 #include "FArrayBox.H"
 #include "GRParmParse.hpp"
 #include "Interval.H"
+#include "LevelData.H"
 #include "REAL.H"
 #include "RealVect.H"
 #include "TensorAlgebra.hpp"
@@ -46,9 +48,29 @@ class PsiAndAijFunctions
     void compute_bowenyork_Aij(Tensor<2, Real> &Aij, // const IntVect &iv,
                                const RealVect &loc);
 
+    // Fill the Bowen York psi and Aij on a level, including ghosts. These
+    // do not change during the solve so are only computed once per level
+    void set_bowenyork_vars(LevelData<FArrayBox> &a_bh_vars,
+                            const RealVect &a_dx,
+                            const std::array<double, SpaceDim> &a_center);
+
+    // Read the Bowen York Aij at a cell from the precomputed values
+    static void get_bowenyork_Aij(Tensor<2, Real> &Aij,
+                                  const FArrayBox &bh_vars_box,
+                                  const IntVect &iv);
+
+    // a_derivs is the DerivativeOperators of multigrid_vars_box, made once
+    // per box by the caller
     void compute_ctt_Aij(Tensor<2, Real> &Aij,
                          const FArrayBox &multigrid_vars_box, const IntVect &iv,
-                         const RealVect &a_dx, const RealVect &loc) const;
+                         const DerivativeOperators &a_derivs,
+                         const RealVect &loc) const;
+
+    void compute_ctt_Aij(Tensor<2, Real> &Aij,
+                         const Tensor<2, Real, SpaceDim> &d1_Vi,
+                         const Tensor<3, Real, SpaceDim> &d2_Vi,
+                         const Tensor<2, Real, SpaceDim> &d2_U,
+                         const RealVect &loc) const;
 
     params_t m_psi_and_Aij_params;
 };
@@ -8,8 +8,10 @@
 #endif
 
 #include "CoarseAverage.H"
+#include "CollectiveHDF5Writer.hpp"
 #include "FilesystemTools.hpp"
 #include "GRParmParse.hpp"
+#include "MultigridVariables.hpp"
 #include "ProblemDomain.H"
 #include "REAL.H"
 #include "RealVect.H"
@@ -22,19 +24,48 @@ struct SimulationParameters<method_t, matter_t>::BaseParams
 {
 
     int max_NL_iter;
+    Real NL_Ham_tolerance;
+    Real NL_Mom_tolerance;
+    Real NL_relative_tolerance;
+    Real NL_update_tolerance;
+    int NL_stagnation_iter;
+    Real NL_stagnation_factor;
+    int error_check_interval;
+    bool use_anderson_mixing;
+    int anderson_depth;
+    Real anderson_mixing;
     bool write_diagnostics;
     int diagnostic_interval;
+    bool async_output;
+    int async_output_queue;
     Real iter_tolerance;
+    bool adaptive_tolerance;
+    Real max_adaptive_tolerance;
     int max_iter;
     int numMGIter;
     int numMGSmooth;
     int preCondSolverDepth;
+    int num_NL_smooth;
+    bool overlap_exchange;
+    bool interleaved_smoother;
+    bool chebyshev_smoother;
+    bool single_precision_smoother;
+    bool direct_bottom_solve;
+    int max_direct_bottom_cells;
+    bool use_fft_solver;
     Real alpha;
     Real beta;
     bool readin_matter_data;
     std::string input_filename;
+    std::vector<std::string> input_matter_names;
+    bool restart;
+    std::string restart_file;
+    int checkpoint_interval;
+    std::string checkpoint_prefix;
     std::string output_filename;
     std::string output_path;
+    bool collective_output;
+    CollectiveHDF5Writer::params_t output_writer_params;
     std::string pout_path;
     std::string error_filename;
     Real G_Newton;
@@ -64,17 +95,108 @@ void SimulationParameters<method_t, matter_t>::read_base_params(GRParmParse &pp)
 #endif
 
     pp.load("max_NL_iterations", base_params.max_NL_iter, 100);
+
+    // Stopping criteria for the NL iterations, a value of zero switches
+    // the corresponding criterion off
+    // Absolute thresholds on the relative Ham and Mom errors (in %)
+    pp.load("NL_Ham_tolerance", base_params.NL_Ham_tolerance, 0.0);
+    pp.load("NL_Mom_tolerance", base_params.NL_Mom_tolerance, 0.0);
+    // Reduction of both errors relative to their values at the first step
+    pp.load("NL_relative_tolerance", base_params.NL_relative_tolerance, 0.0);
+    // Max norm of the correction found by the linear solver
+    pp.load("NL_update_tolerance", base_params.NL_update_tolerance, 0.0);
+    // Stop if the errors have not dropped below NL_stagnation_factor times
+    // their value NL_stagnation_iterations steps earlier
+    pp.load("NL_stagnation_iterations", base_params.NL_stagnation_iter, 0);
+    pp.load("NL_stagnation_factor", base_params.NL_stagnation_factor, 0.99);
+    // Only compute the Ham and Mom errors (and so test the criteria based
+    // on them) every error_check_interval steps. They are always computed
+    // at the first step, at those where the diagnostics are written out and
+    // on the final solution. The stagnation test then counts checks, not
+    // steps.
+    pp.load("error_check_interval", base_params.error_check_interval, 1);
+    if (base_params.error_check_interval < 1)
+    {
+        MayDay::Error("bad error_check_interval in input");
+    }
+
+    // Acceleration of the NL iterations, "none" gives plain Picard steps
+    base_params.use_anderson_mixing = false;
+    if (pp.contains("NL_accelerator"))
+    {
+        std::string accelerator;
+        pp.get("NL_accelerator", accelerator);
+        if (accelerator == "anderson")
+        {
+            base_params.use_anderson_mixing = true;
+        }
+        else if (accelerator != "none")
+        {
+            MayDay::Error("bad NL_accelerator in input");
+        }
+    }
+    // number of previous iterates used and damping of the Anderson update
+    pp.load("anderson_depth", base_params.anderson_depth, 5);
+    pp.load("anderson_mixing", base_params.anderson_mixing, 1.0);
+    if (base_params.anderson_depth < 1)
+    {
+        MayDay::Error("bad anderson_depth in input");
+    }
     pp.load("write_diagnostics", base_params.write_diagnostics, true);
     pp.load("diagnostic_interval", base_params.diagnostic_interval, 10);
+    // Write the diagnostic files from a background thread while the solver
+    // continues (single rank only, in builds with NTIMER=TRUE, and under
+    // MPI only with MPI_THREAD_MULTIPLE), holding at most
+    // async_output_queue copies of the data at a time
+    pp.load("async_output", base_params.async_output, false);
+    pp.load("async_output_queue", base_params.async_output_queue, 2);
+    if (base_params.async_output_queue < 1)
+    {
+        MayDay::Error("bad async_output_queue in input");
+    }
 
     // Setup multigrid params, most of them defaulted
 
     pp.load("iter_tolerance", base_params.iter_tolerance, 1e-10);
+    // Tie the linear tolerance to the NL errors (Eisenstat-Walker) so
+    // that early NL steps are not solved more accurately than needed,
+    // iter_tolerance is then used as the floor
+    pp.load("adaptive_tolerance", base_params.adaptive_tolerance, false);
+    pp.load("max_adaptive_tolerance", base_params.max_adaptive_tolerance,
+            0.1);
     pp.load("max_iterations", base_params.max_iter, 100);
     pp.load("numMGIterations", base_params.numMGIter, 4);
     pp.load("numMGsmooth", base_params.numMGSmooth, 4);
     pp.load("preCondSolverDepth", base_params.preCondSolverDepth, -1);
 
+    // Number of nonlinear Gauss-Seidel sweeps of the full psi equation
+    // before each linearised solve (only CTTKHybrid has such an equation,
+    // CTTK rejects num_NL_smooth > 0)
+    pp.load("num_NL_smooth", base_params.num_NL_smooth, 0);
+
+    // Smooth the interior of the boxes while the ghost cells are exchanged
+    // in the multigrid solver (only helps when running on several nodes)
+    pp.load("overlap_exchange", base_params.overlap_exchange, false);
+    // Use the C++ smoother kernel which does all the constraint components
+    // in one sweep, rather than the Fortran one
+    pp.load("interleaved_smoother", base_params.interleaved_smoother, false);
+    // Use a Chebyshev smoother, which needs half as many exchanges, instead
+    // of red-black Gauss-Seidel
+    pp.load("chebyshev_smoother", base_params.chebyshev_smoother, false);
+    // Use single precision coefficients in the GSRB smoother of the
+    // multigrid preconditioner (the linear solve itself stays in double)
+    pp.load("single_precision_smoother",
+            base_params.single_precision_smoother, false);
+    // Solve the coarsest multigrid level directly with a cached LU
+    // factorisation, if it has no more than max_direct_bottom_cells cells
+    pp.load("direct_bottom_solve", base_params.direct_bottom_solve, false);
+    pp.load("max_direct_bottom_cells", base_params.max_direct_bottom_cells,
+            1024);
+    // Solve with FFTs instead of multigrid on a single periodic level,
+    // exactly when the coefficients are constant, otherwise as the initial
+    // guess of the linear solver
+    pp.load("use_fft_solver", base_params.use_fft_solver, false);
+
     // Params for variable coefficient multigrid solver, solving the eqn
     // alpha*aCoef(x)*I - beta*bCoef(x) * laplacian = rhs
     // spatially-varying aCoef and bCoef are set in Methods
@@ -87,6 +209,20 @@ void SimulationParameters<method_t, matter_t>::read_base_params(GRParmParse &pp)
     {
         pp.get("input_filename", base_params.input_filename);
         base_params.readin_matter_data = true;
+
+        // Names of the matter variables in the file, by default the
+        // GRChombo ones (i.e. without the _0 suffix)
+        std::vector<std::string> default_names;
+        for (std::string name : MatterVariables::variable_names)
+        {
+            if (name.size() > 2 && name.substr(name.size() - 2) == "_0")
+            {
+                name.resize(name.size() - 2);
+            }
+            default_names.push_back(name);
+        }
+        pp.load("input_matter_names", base_params.input_matter_names,
+                NUM_MULTIGRID_VARS - NUM_METRIC_VARS, default_names);
     }
     else
     {
@@ -94,6 +230,19 @@ void SimulationParameters<method_t, matter_t>::read_base_params(GRParmParse &pp)
         base_params.readin_matter_data = false;
     }
 
+    // Resume the NL solve from a checkpoint of a previous run, the grids
+    // are read from the checkpoint instead of being generated
+    if (pp.contains("restart_file"))
+    {
+        pp.get("restart_file", base_params.restart_file);
+        base_params.restart = true;
+    }
+    else
+    {
+        base_params.restart_file = "";
+        base_params.restart = false;
+    }
+
     // Error outputs
     if (pp.contains("error_filename"))
     {
@@ -128,6 +277,32 @@ void SimulationParameters<method_t, matter_t>::read_base_params(GRParmParse &pp)
             base_params.output_path + "InitialDataFinal.3d.hdf5";
     }
 
+    // Write a restart checkpoint every checkpoint_interval NL iterations,
+    // 0 = never
+    pp.load("checkpoint_interval", base_params.checkpoint_interval, 0);
+    std::string checkpoint_prefix;
+    pp.load("checkpoint_prefix", checkpoint_prefix,
+            std::string("NL_checkpoint_"));
+    base_params.checkpoint_prefix =
+        base_params.output_path + checkpoint_prefix;
+
+    // Write the final data with one collective MPI-IO write per level,
+    // optionally chunked and compressed (the file can still be read by
+    // GRChombo as usual)
+    pp.load("collective_output", base_params.collective_output, false);
+    // deflate level from 1 to 9, 0 = no compression
+    pp.load("output_compression_level",
+            base_params.output_writer_params.compression_level, 0);
+    // number of Reals per chunk when compressing
+    pp.load("output_chunk_size", base_params.output_writer_params.chunk_size,
+            1 << 20);
+    // number of MPI-IO aggregators, 0 = the MPI default
+    pp.load("output_aggregators",
+            base_params.output_writer_params.num_aggregators, 0);
+    // alignment of the datasets in the file in bytes, 0 = off
+    pp.load("output_alignment", base_params.output_writer_params.alignment,
+            0);
+
     pp.load("G_Newton", base_params.G_Newton, 1.0);
     pp.load("verbosity", base_params.verbosity, 1);
 }
@@ -23,10 +23,13 @@ void ScalarField::initialise_matter_vars(LevelData<FArrayBox> &a_multigrid_vars,
     CH_assert(a_multigrid_vars.nComp() == NUM_MULTIGRID_VARS);
 
     DataIterator dit = a_multigrid_vars.dataIterator();
-    for (dit.begin(); dit.ok(); ++dit)
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
     {
+        DataIndex dind = dit[ibox];
         // These contain the vars in the boxes, set them all to zero
-        FArrayBox &multigrid_vars_box = a_multigrid_vars[dit()];
+        FArrayBox &multigrid_vars_box = a_multigrid_vars[dind];
 
         // Iterate over the box and set non zero comps
         Box ghosted_box = multigrid_vars_box.box();
@@ -47,23 +50,20 @@ void ScalarField::initialise_matter_vars(LevelData<FArrayBox> &a_multigrid_vars,
 
 // template <class data_t>
 emtensor_t ScalarField::compute_emtensor(const IntVect a_iv,
-                                         const RealVect &a_dx,
-                                         FArrayBox &a_multigrid_vars_box) const
+                                         const DerivativeOperators &a_derivs,
+                                         FArrayBox &a_multigrid_vars_box,
+                                         const FArrayBox &a_bh_vars_box) const
 {
     emtensor_t out;
 
-    DerivativeOperators derivs(a_dx);
-    RealVect loc;
-    Grids::get_loc(loc, a_iv, a_dx, center);
-
     Real psi_reg = a_multigrid_vars_box(a_iv, c_psi_reg);
-    Real psi_bh = psi_and_Aij_functions->compute_bowenyork_psi(loc);
+    Real psi_bh = a_bh_vars_box(a_iv, c_psi_bh);
     Real psi_0 = psi_reg + psi_bh;
     Real Pi_0 = a_multigrid_vars_box(a_iv, c_Pi_0);
     Real phi_0 = a_multigrid_vars_box(a_iv, c_phi_0);
 
     Tensor<1, Real, SpaceDim> d1_phi;
-    derivs.get_d1(d1_phi, a_iv, a_multigrid_vars_box, c_phi_0);
+    a_derivs.get_d1(d1_phi, a_iv, a_multigrid_vars_box, c_phi_0);
     Real d1_phi_squared = 0;
     FOR1(i) { d1_phi_squared += d1_phi[i] * d1_phi[i]; }
 
@@ -6,6 +6,7 @@
 #ifndef SCALARFIELD_HPP_
 #define SCALARFIELD_HPP_
 
+#include "DerivativeOperators.hpp"
 #include "EMTensor.hpp"
 #include "FArrayBox.H"
 #include "GRParmParse.hpp"
@@ -33,10 +34,13 @@ class ScalarField
     }
 
     //! The function which calculates the EM Tensor, given the vars and
-    //! derivatives, including the potential
+    //! derivatives (a_derivs is made once per box by the caller), including
+    //! the potential
     // template <class data_t>
-    emtensor_t compute_emtensor(const IntVect a_iv, const RealVect &a_dx,
-                                FArrayBox &a_multigrid_vars_box) const;
+    emtensor_t compute_emtensor(const IntVect a_iv,
+                                const DerivativeOperators &a_derivs,
+                                FArrayBox &a_multigrid_vars_box,
+                                const FArrayBox &a_bh_vars_box) const;
 
     static void read_params(GRParmParse &pp, params_t &matter_params)
     {
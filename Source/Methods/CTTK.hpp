@@ -33,13 +33,22 @@ template <typename matter_t> class CTTK
                                     const RealVect &a_dx) const;
 
     void solve_analytic(LevelData<FArrayBox> *multigrid_vars,
+                        LevelData<FArrayBox> *bh_vars,
                         LevelData<FArrayBox> *rhs, const RealVect &a_dx);
 
+    // If a_diagnostic_vars is given the constraint diagnostics are
+    // calculated in the same sweep, reusing the shared terms
     void set_elliptic_terms(LevelData<FArrayBox> *a_multigrid_vars,
+                            LevelData<FArrayBox> *a_bh_vars,
                             LevelData<FArrayBox> *a_rhs,
                             RefCountedPtr<LevelData<FArrayBox>> a_aCoef,
                             RefCountedPtr<LevelData<FArrayBox>> a_bCoef,
-                            const RealVect &a_dx);
+                            const RealVect &a_dx,
+                            LevelData<FArrayBox> *a_diagnostic_vars = NULL);
+
+    void relax_psi(LevelData<FArrayBox> *a_multigrid_vars,
+                   LevelData<FArrayBox> *a_bh_vars, const RealVect &a_dx,
+                   const int a_colour);
 
     params_t m_method_params;
     PsiAndAijFunctions::params_t m_psi_and_Aij_params;
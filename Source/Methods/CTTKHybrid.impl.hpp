@@ -7,6 +7,7 @@
 #error "This file should only be included through CTTKHybrid.hpp"
 #endif
 
+#include "ConstraintTerms.hpp"
 #include "DimensionDefinitions.hpp"
 #include "GRParmParse.hpp"
 #include "Tensor.hpp"
@@ -18,6 +19,7 @@ template <typename matter_t> struct CTTKHybrid<matter_t>::params_t
     bool use_compact_Vi_ansatz;
     Real regularised_part_psi;
     bool deactivate_zero_mode;
+    bool deflate_zero_mode;
 };
 
 template <typename matter_t>
@@ -42,22 +44,32 @@ void CTTKHybrid<matter_t>::read_params(GRParmParse &pp,
     pp.load("regularised_part_psi", a_method_params.regularised_part_psi, 1.0);
     pp.load("deactivate_zero_mode", a_method_params.deactivate_zero_mode,
             false);
+    pp.load("deflate_zero_mode", a_method_params.deflate_zero_mode, false);
 }
 
 template <typename matter_t>
 void CTTKHybrid<matter_t>::solve_analytic(
-    LevelData<FArrayBox> *a_multigrid_vars, LevelData<FArrayBox> *a_rhs,
-    const RealVect &a_dx)
+    LevelData<FArrayBox> *a_multigrid_vars, LevelData<FArrayBox> *a_bh_vars,
+    LevelData<FArrayBox> *a_rhs, const RealVect &a_dx)
 {
-    DerivativeOperators derivs(a_dx);
     // Iterate through the boxes in turn
     DataIterator dit = a_rhs->dataIterator();
-    for (dit.begin(); dit.ok(); ++dit)
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
     {
-        FArrayBox &multigrid_vars_box = (*a_multigrid_vars)[dit()];
-        FArrayBox &rhs_box = (*a_rhs)[dit()];
+        DataIndex dind = dit[ibox];
+        FArrayBox &multigrid_vars_box = (*a_multigrid_vars)[dind];
+        DerivativeOperators derivs(a_dx, multigrid_vars_box.box());
+        const FArrayBox &bh_vars_box = (*a_bh_vars)[dind];
+        FArrayBox &rhs_box = (*a_rhs)[dind];
         Box unghosted_box = rhs_box.box();
 
+        // Laplacian of psi_reg over the whole box in one pass
+        FArrayBox laplacian_psi_reg_box(unghosted_box, 1);
+        derivs.scalar_Laplacian(laplacian_psi_reg_box, 0, multigrid_vars_box,
+                                c_psi_reg, unghosted_box);
+
         // Iterate through the interior of boxes
         // (ghosts need to be filled later due to gradient terms)
         BoxIterator bit(unghosted_box);
@@ -70,18 +82,16 @@ void CTTKHybrid<matter_t>::solve_analytic(
 
             // Calculate the actual value of psi including BH part
             Real psi_reg = multigrid_vars_box(iv, c_psi_reg);
-            Real psi_bh = psi_and_Aij_functions->compute_bowenyork_psi(loc);
+            Real psi_bh = bh_vars_box(iv, c_psi_bh);
             Real psi_0 = psi_reg + psi_bh;
-            Real laplacian_psi_reg;
-            derivs.scalar_Laplacian(laplacian_psi_reg, iv, multigrid_vars_box,
-                                    c_psi_reg);
+            Real laplacian_psi_reg = laplacian_psi_reg_box(iv, 0);
 
             // Assign values of Aij
             Tensor<2, Real> Aij_reg;
             psi_and_Aij_functions->compute_ctt_Aij(Aij_reg, multigrid_vars_box,
-                                                   iv, a_dx, loc);
+                                                   iv, derivs, loc);
             Tensor<2, Real> Aij_bh;
-            psi_and_Aij_functions->compute_bowenyork_Aij(Aij_bh, loc);
+            PsiAndAijFunctions::get_bowenyork_Aij(Aij_bh, bh_vars_box, iv);
             // This is \bar  A_ij \bar A^ij
             Real A2_0 = 0.0;
             FOR2(i, j)
@@ -91,8 +101,8 @@ void CTTKHybrid<matter_t>::solve_analytic(
             }
 
             // Compute emtensor components
-            const auto emtensor =
-                matter->compute_emtensor(iv, a_dx, multigrid_vars_box);
+            const auto emtensor = matter->compute_emtensor(
+                iv, derivs, multigrid_vars_box, bh_vars_box);
 
             // Set value for K
             Real K_0_squared = 24.0 * M_PI * G_Newton * emtensor.rho;
@@ -114,18 +124,28 @@ void CTTKHybrid<matter_t>::solve_analytic(
 
 template <typename matter_t>
 void CTTKHybrid<matter_t>::set_elliptic_terms(
-    LevelData<FArrayBox> *a_multigrid_vars, LevelData<FArrayBox> *a_rhs,
-    RefCountedPtr<LevelData<FArrayBox>> a_aCoef,
-    RefCountedPtr<LevelData<FArrayBox>> a_bCoef, const RealVect &a_dx)
+    LevelData<FArrayBox> *a_multigrid_vars, LevelData<FArrayBox> *a_bh_vars,
+    LevelData<FArrayBox> *a_rhs, RefCountedPtr<LevelData<FArrayBox>> a_aCoef,
+    RefCountedPtr<LevelData<FArrayBox>> a_bCoef, const RealVect &a_dx,
+    LevelData<FArrayBox> *a_diagnostic_vars)
 {
-    DerivativeOperators derivs(a_dx);
     DataIterator dit = a_rhs->dataIterator();
-    for (dit.begin(); dit.ok(); ++dit)
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
     {
-        FArrayBox &multigrid_vars_box = (*a_multigrid_vars)[dit()];
-        FArrayBox &rhs_box = (*a_rhs)[dit()];
-        FArrayBox &aCoef_box = (*a_aCoef)[dit()];
-        FArrayBox &bCoef_box = (*a_bCoef)[dit()];
+        DataIndex dind = dit[ibox];
+        FArrayBox &multigrid_vars_box = (*a_multigrid_vars)[dind];
+        DerivativeOperators derivs(a_dx, multigrid_vars_box.box());
+        const FArrayBox &bh_vars_box = (*a_bh_vars)[dind];
+        FArrayBox &rhs_box = (*a_rhs)[dind];
+        FArrayBox &aCoef_box = (*a_aCoef)[dind];
+        FArrayBox &bCoef_box = (*a_bCoef)[dind];
+        FArrayBox *diagnostic_vars_box = NULL;
+        if (a_diagnostic_vars != NULL)
+        {
+            diagnostic_vars_box = &(*a_diagnostic_vars)[dind];
+        }
         // JCAurre: Initialise rhs=0, aCoef=0 and bCoef=1 for all constraint
         // variables
         for (int comp = 0; comp < NUM_CONSTRAINT_VARS; comp++)
@@ -136,13 +156,23 @@ void CTTKHybrid<matter_t>::set_elliptic_terms(
 
             // this prevents small amounts of noise in the sources
             // activating the zero modes - (Garfinkle trick) see 2207.03125
-            if (m_method_params.deactivate_zero_mode)
+            // Not needed if the solver deflates the zero mode exactly
+            if (m_method_params.deactivate_zero_mode &&
+                !m_method_params.deflate_zero_mode)
             {
                 Real small_number = 1e-10;
                 aCoef_box.setVal(-small_number, comp);
             }
         }
         Box unghosted_box = rhs_box.box();
+        // Laplacian of psi_reg over the whole box in one pass
+        FArrayBox laplacian_psi_reg_box(unghosted_box, 1);
+        derivs.scalar_Laplacian(laplacian_psi_reg_box, 0, multigrid_vars_box,
+                                c_psi_reg, unghosted_box);
+        // and the gradient of K
+        FArrayBox d1_K_box(unghosted_box, SpaceDim);
+        derivs.get_d1(d1_K_box, 0, multigrid_vars_box, c_K_0, unghosted_box);
+
         BoxIterator bit(unghosted_box);
         for (bit.begin(); bit.ok(); ++bit)
         {
@@ -154,18 +184,27 @@ void CTTKHybrid<matter_t>::set_elliptic_terms(
 
             // Calculate the actual value of psi including BH part
             Real psi_reg = multigrid_vars_box(iv, c_psi_reg);
-            Real psi_bh = psi_and_Aij_functions->compute_bowenyork_psi(loc);
+            Real psi_bh = bh_vars_box(iv, c_psi_bh);
             Real psi_0 = psi_reg + psi_bh;
-            Real laplacian_psi_reg;
-            derivs.scalar_Laplacian(laplacian_psi_reg, iv, multigrid_vars_box,
-                                    c_psi_reg);
+            Real laplacian_psi_reg = laplacian_psi_reg_box(iv, 0);
+
+            // Get the derivatives of Vi and U, these are shared by Aij,
+            // the rhs and the diagnostics
+            Tensor<2, Real, SpaceDim> di_Vi;
+            derivs.get_d1_vector(di_Vi, iv, multigrid_vars_box,
+                                 Interval(c_V1_0, c_V3_0));
+            Tensor<3, Real, SpaceDim> d2_Vi;
+            derivs.get_d2_vector(d2_Vi, iv, multigrid_vars_box,
+                                 Interval(c_V1_0, c_V3_0));
+            Tensor<2, Real, SpaceDim> d2_U;
+            derivs.get_d2(d2_U, iv, multigrid_vars_box, c_U_0);
 
             // Get values of Aij
             Tensor<2, Real> Aij_reg;
-            psi_and_Aij_functions->compute_ctt_Aij(Aij_reg, multigrid_vars_box,
-                                                   iv, a_dx, loc);
+            psi_and_Aij_functions->compute_ctt_Aij(Aij_reg, di_Vi, d2_Vi, d2_U,
+                                                   loc);
             Tensor<2, Real> Aij_bh;
-            psi_and_Aij_functions->compute_bowenyork_Aij(Aij_bh, loc);
+            PsiAndAijFunctions::get_bowenyork_Aij(Aij_bh, bh_vars_box, iv);
             // This is \bar  A_ij \bar A^ij
             Real A2_0 = 0.0;
             FOR2(i, j)
@@ -175,27 +214,25 @@ void CTTKHybrid<matter_t>::set_elliptic_terms(
             }
 
             // Compute emtensor components
-            const auto emtensor =
-                matter->compute_emtensor(iv, a_dx, multigrid_vars_box);
+            const auto emtensor = matter->compute_emtensor(
+                iv, derivs, multigrid_vars_box, bh_vars_box);
 
             Tensor<1, Real, SpaceDim> d1_K;
-            derivs.get_d1(d1_K, iv, multigrid_vars_box, c_K_0);
+            FOR1(i) { d1_K[i] = d1_K_box(iv, i); }
 
             // rhs terms, K is set to cancel matter terms only
             rhs_box(iv, c_psi) =
                 -0.125 * A2_0 * pow(psi_0, -7.0) - laplacian_psi_reg;
 
-            // Get d_i V_i and laplacians
-            Tensor<2, Real, SpaceDim> di_Vi;
-            derivs.get_d1_vector(di_Vi, iv, multigrid_vars_box,
-                                 Interval(c_V1_0, c_V3_0));
-
+            // laplacians from the second derivatives
             Tensor<1, Real, SpaceDim> laplacian_V;
-            derivs.vector_Laplacian(laplacian_V, iv, multigrid_vars_box,
-                                    Interval(c_V1_0, c_V3_0));
-
-            Real laplacian_U;
-            derivs.scalar_Laplacian(laplacian_U, iv, multigrid_vars_box, c_U_0);
+            Real laplacian_U = 0.0;
+            FOR1(i)
+            {
+                laplacian_V[i] = 0.0;
+                FOR1(j) { laplacian_V[i] += d2_Vi[i][j][j]; }
+                laplacian_U += d2_U[i][i];
+            }
 
             // now set the values in the box
             rhs_box(iv, c_V1) =
@@ -237,6 +274,84 @@ void CTTKHybrid<matter_t>::set_elliptic_terms(
 
             // add the aCoef term
             aCoef_box(iv, c_psi) += -0.875 * A2_0 * pow(psi_0, -8.0);
+
+            // fill the constraint diagnostics in the same sweep
+            if (diagnostic_vars_box != NULL)
+            {
+                ConstraintTerms::set_constraint_terms(
+                    *diagnostic_vars_box, iv, psi_0,
+                    multigrid_vars_box(iv, c_K_0), laplacian_psi_reg, A2_0,
+                    emtensor, d1_K, d2_Vi, G_Newton);
+            }
+        }
+    }
+}
+
+// Nonlinear Gauss-Seidel relaxation of the full Lichnerowicz equation
+//    Laplacian(psi) + 1/8 A2 psi^-7 = 0
+// (the matter terms are cancelled by K) on the cells of one colour,
+// using a pointwise Newton step. The Vi and U are held fixed.
+template <typename matter_t>
+void CTTKHybrid<matter_t>::relax_psi(LevelData<FArrayBox> *a_multigrid_vars,
+                                     LevelData<FArrayBox> *a_bh_vars,
+                                     const RealVect &a_dx, const int a_colour)
+{
+    const DisjointBoxLayout &grids = a_multigrid_vars->disjointBoxLayout();
+    DataIterator dit = a_multigrid_vars->dataIterator();
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
+    {
+        DataIndex dind = dit[ibox];
+        FArrayBox &multigrid_vars_box = (*a_multigrid_vars)[dind];
+        DerivativeOperators derivs(a_dx, multigrid_vars_box.box());
+        const FArrayBox &bh_vars_box = (*a_bh_vars)[dind];
+        Box unghosted_box = grids[dind];
+
+        BoxIterator bit(unghosted_box);
+        for (bit.begin(); bit.ok(); ++bit)
+        {
+            IntVect iv = bit();
+            int parity = (iv.sum() % 2 + 2) % 2;
+            if (parity != a_colour)
+            {
+                continue;
+            }
+
+            // work out location on the grid
+            RealVect loc;
+            Grids::get_loc(loc, iv, a_dx, center);
+
+            // Calculate the actual value of psi including BH part
+            Real psi_reg = multigrid_vars_box(iv, c_psi_reg);
+            Real psi_bh = bh_vars_box(iv, c_psi_bh);
+            Real psi_0 = psi_reg + psi_bh;
+            Real laplacian_psi_reg;
+            derivs.scalar_Laplacian(laplacian_psi_reg, iv, multigrid_vars_box,
+                                    c_psi_reg);
+
+            // Get values of Aij
+            Tensor<2, Real> Aij_reg;
+            psi_and_Aij_functions->compute_ctt_Aij(Aij_reg, multigrid_vars_box,
+                                                   iv, derivs, loc);
+            Tensor<2, Real> Aij_bh;
+            PsiAndAijFunctions::get_bowenyork_Aij(Aij_bh, bh_vars_box, iv);
+            // This is \bar  A_ij \bar A^ij
+            Real A2_0 = 0.0;
+            FOR2(i, j)
+            {
+                A2_0 += (Aij_reg[i][j] + Aij_bh[i][j]) *
+                        (Aij_reg[i][j] + Aij_bh[i][j]);
+            }
+
+            // residual of the Hamiltonian constraint and its derivative
+            // with respect to psi in this cell
+            Real residual = laplacian_psi_reg + 0.125 * A2_0 * pow(psi_0, -7.0);
+            Real diagonal = 0.0;
+            FOR1(i) { diagonal += -2.0 / (a_dx[i] * a_dx[i]); }
+            diagonal += -0.875 * A2_0 * pow(psi_0, -8.0);
+
+            multigrid_vars_box(iv, c_psi_reg) = psi_reg - residual / diagonal;
         }
     }
 }
@@ -248,10 +363,13 @@ void CTTKHybrid<matter_t>::initialise_method_vars(
     CH_assert(a_multigrid_vars.nComp() == NUM_MULTIGRID_VARS);
 
     DataIterator dit = a_multigrid_vars.dataIterator();
-    for (dit.begin(); dit.ok(); ++dit)
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
     {
+        DataIndex dind = dit[ibox];
         // These contain the vars in the boxes, set them all to zero
-        FArrayBox &multigrid_vars_box = a_multigrid_vars[dit()];
+        FArrayBox &multigrid_vars_box = a_multigrid_vars[dind];
         for (int comp = 0; comp < NUM_MULTIGRID_VARS; comp++)
         {
             multigrid_vars_box.setVal(0.0, comp);
@@ -284,10 +402,13 @@ void CTTKHybrid<matter_t>::initialise_constraint_vars(
 {
 
     DataIterator dit = a_constraint_vars.dataIterator();
-    for (dit.begin(); dit.ok(); ++dit)
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
     {
+        DataIndex dind = dit[ibox];
         // These contain the vars in the boxes, set them all to zero
-        FArrayBox &constraint_vars_box = a_constraint_vars[dit()];
+        FArrayBox &constraint_vars_box = a_constraint_vars[dind];
 
         for (int comp = 0; comp < NUM_CONSTRAINT_VARS; comp++)
         {
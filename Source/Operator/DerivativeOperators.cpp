@@ -4,67 +4,54 @@
  */
 
 #include "DerivativeOperators.hpp"
+#include "BoxIterator.H"
 #include "Interval.H"
 #include "REAL.H"
 #include "Tensor.hpp"
 #include "TensorAlgebra.hpp"
 
+// The stencils below work directly on the data pointer of the box, using
+// the memory offsets to the neighbouring cells rather than building shifted
+// IntVects and going through FArrayBox::operator() for every point
+
 void DerivativeOperators::get_d1(Tensor<1, Real, SpaceDim> &d1,
                                  const IntVect &a_iv,
-                                 const FArrayBox &a_vars_box, const int icomp)
+                                 const FArrayBox &a_vars_box,
+                                 const int icomp) const
 {
+    CH_assert(a_vars_box.box().size() == m_box_size);
+    const Real *ptr = &a_vars_box(a_iv, icomp);
+
     FOR1(idir)
     {
-        IntVect iv_offset1 = a_iv;
-        IntVect iv_offset2 = a_iv;
-        iv_offset1[idir] -= 1;
-        iv_offset2[idir] += 1;
-
-        d1[idir] =
-            0.5 *
-            (a_vars_box(iv_offset2, icomp) - a_vars_box(iv_offset1, icomp)) /
-            m_dx[idir];
+        const int s = m_strides[idir];
+        d1[idir] = 0.5 * (ptr[s] - ptr[-s]) * m_one_over_dx[idir];
     }
 }
 
 void DerivativeOperators::get_d2(Tensor<2, Real, SpaceDim> &d2,
                                  const IntVect &a_iv,
-                                 const FArrayBox &a_vars_box, const int icomp)
+                                 const FArrayBox &a_vars_box,
+                                 const int icomp) const
 {
-    FOR2(idir1, idir2)
+    CH_assert(a_vars_box.box().size() == m_box_size);
+    const Real *ptr = &a_vars_box(a_iv, icomp);
+
+    FOR1(idir1)
     {
-        if (idir1 != idir2)
-        {
-            IntVect iv_offset1 = a_iv;
-            IntVect iv_offset2 = a_iv;
-            IntVect iv_offset3 = a_iv;
-            IntVect iv_offset4 = a_iv;
-            iv_offset1[idir1] -= 1;
-            iv_offset1[idir2] -= 1;
-            iv_offset2[idir1] += 1;
-            iv_offset2[idir2] += 1;
-            iv_offset3[idir1] += 1;
-            iv_offset3[idir2] -= 1;
-            iv_offset4[idir1] -= 1;
-            iv_offset4[idir2] += 1;
-
-            d2[idir1][idir2] =
-                (a_vars_box(iv_offset1, icomp) + a_vars_box(iv_offset2, icomp) -
-                 a_vars_box(iv_offset3, icomp) -
-                 a_vars_box(iv_offset4, icomp)) /
-                (4.0 * m_dx[idir1] * m_dx[idir2]);
-        }
-        else
+        const int s1 = m_strides[idir1];
+        d2[idir1][idir1] =
+            (ptr[-s1] - 2.0 * ptr[0] + ptr[s1]) * m_one_over_dx2[idir1];
+
+        // mixed derivatives are symmetric so only calculate them once
+        for (int idir2 = idir1 + 1; idir2 < SpaceDim; idir2++)
         {
-            IntVect iv_offset1 = a_iv;
-            IntVect iv_offset2 = a_iv;
-            iv_offset1[idir1] -= 1;
-            iv_offset2[idir1] += 1;
-
-            d2[idir1][idir1] =
-                (a_vars_box(iv_offset1, icomp) - 2.0 * a_vars_box(a_iv, icomp) +
-                 a_vars_box(iv_offset2, icomp)) /
-                (m_dx[idir1] * m_dx[idir1]);
+            const int s2 = m_strides[idir2];
+            d2[idir1][idir2] = (ptr[-s1 - s2] + ptr[s1 + s2] - ptr[s1 - s2] -
+                                ptr[-s1 + s2]) *
+                               0.25 * m_one_over_dx[idir1] *
+                               m_one_over_dx[idir2];
+            d2[idir2][idir1] = d2[idir1][idir2];
         }
     }
 }
@@ -72,73 +59,118 @@ void DerivativeOperators::get_d2(Tensor<2, Real, SpaceDim> &d2,
 void DerivativeOperators::get_d1_vector(Tensor<2, Real, SpaceDim> &d1,
                                         const IntVect &a_iv,
                                         const FArrayBox &a_vars_box,
-                                        const Interval &a_interval)
+                                        const Interval &a_interval) const
 {
-    // get the derivs for each component
-    Tensor<1, Real, SpaceDim> d1_comp1, d1_comp2, d1_comp3;
-    get_d1(d1_comp1, a_iv, a_vars_box, a_interval.begin());
-    get_d1(d1_comp2, a_iv, a_vars_box, a_interval.begin() + 1);
-    get_d1(d1_comp3, a_iv, a_vars_box, a_interval.end());
-
-    using namespace TensorAlgebra;
-    FOR2(i, j)
+    // the vector components are consecutive in the interval
+    FOR1(i)
     {
-        d1[i][j] = delta(i, 0) * d1_comp1[j] + delta(i, 1) * d1_comp2[j] +
-                   delta(i, 2) * d1_comp3[j];
+        Tensor<1, Real, SpaceDim> d1_comp;
+        get_d1(d1_comp, a_iv, a_vars_box, a_interval.begin() + i);
+        FOR1(j) { d1[i][j] = d1_comp[j]; }
     }
 }
 
 void DerivativeOperators::get_d2_vector(Tensor<3, Real, SpaceDim> &d2,
                                         const IntVect &a_iv,
                                         const FArrayBox &a_vars_box,
-                                        const Interval &a_interval)
+                                        const Interval &a_interval) const
 {
-    // get the derivs for each component
-    Tensor<2, Real, SpaceDim> d2_comp1, d2_comp2, d2_comp3;
-    get_d2(d2_comp1, a_iv, a_vars_box, a_interval.begin());
-    get_d2(d2_comp2, a_iv, a_vars_box, a_interval.begin() + 1);
-    get_d2(d2_comp3, a_iv, a_vars_box, a_interval.end());
-
-    using namespace TensorAlgebra;
-    FOR3(i, j, k)
+    // the vector components are consecutive in the interval
+    FOR1(i)
     {
-        d2[i][j][k] = delta(i, 0) * d2_comp1[j][k] +
-                      delta(i, 1) * d2_comp2[j][k] +
-                      delta(i, 2) * d2_comp3[j][k];
+        Tensor<2, Real, SpaceDim> d2_comp;
+        get_d2(d2_comp, a_iv, a_vars_box, a_interval.begin() + i);
+        FOR2(j, k) { d2[i][j][k] = d2_comp[j][k]; }
     }
 }
 
 void DerivativeOperators::scalar_Laplacian(Real &laplacian, const IntVect &a_iv,
                                            const FArrayBox &a_vars_box,
-                                           const int a_comp)
+                                           const int a_comp) const
 {
+    CH_assert(a_vars_box.box().size() == m_box_size);
+    const Real *ptr = &a_vars_box(a_iv, a_comp);
+
+    // 2nd order stencil
     laplacian = 0.0;
     FOR1(idir)
     {
-        IntVect iv_offset1 = a_iv;
-        IntVect iv_offset2 = a_iv;
-        iv_offset1[idir] -= 1;
-        iv_offset2[idir] += 1;
-
-        // 2nd order stencil
-        Real d2comp_dxdx = 1.0 / (m_dx[idir] * m_dx[idir]) *
-                           (1.0 * a_vars_box(iv_offset2, a_comp) -
-                            2.0 * a_vars_box(a_iv, a_comp) +
-                            1.0 * a_vars_box(iv_offset1, a_comp));
-        laplacian += d2comp_dxdx;
+        const int s = m_strides[idir];
+        laplacian += (ptr[s] - 2.0 * ptr[0] + ptr[-s]) * m_one_over_dx2[idir];
     }
 }
 
 void DerivativeOperators::vector_Laplacian(Tensor<1, Real, SpaceDim> &laplacian,
                                            const IntVect &a_iv,
                                            const FArrayBox &a_vars_box,
-                                           const Interval &a_interval)
+                                           const Interval &a_interval) const
 {
-    Real laplacian1, laplacian2, laplacian3;
-    scalar_Laplacian(laplacian1, a_iv, a_vars_box, a_interval.begin());
-    scalar_Laplacian(laplacian2, a_iv, a_vars_box, a_interval.begin() + 1);
-    scalar_Laplacian(laplacian3, a_iv, a_vars_box, a_interval.end());
-    laplacian[0] = laplacian1;
-    laplacian[1] = laplacian2;
-    laplacian[2] = laplacian3;
-}
\ No newline at end of file
+    FOR1(i)
+    {
+        scalar_Laplacian(laplacian[i], a_iv, a_vars_box,
+                         a_interval.begin() + i);
+    }
+}
+
+void DerivativeOperators::get_d1(FArrayBox &a_d1, const int a_out_comp,
+                                 const FArrayBox &a_vars_box, const int a_comp,
+                                 const Box &a_box) const
+{
+    CH_assert(a_vars_box.box().size() == m_box_size);
+    CH_assert(a_vars_box.box().contains(grow(a_box, 1)));
+    CH_assert(a_d1.box().contains(a_box));
+
+    // the first cell of each row in the unit stride direction
+    Box row_starts = a_box;
+    row_starts.setBig(0, a_box.smallEnd(0));
+    const int length = a_box.size(0);
+    BoxIterator bit(row_starts);
+    for (bit.begin(); bit.ok(); ++bit)
+    {
+        const Real *in = &a_vars_box(bit(), a_comp);
+        FOR1(idir)
+        {
+            const int s = m_strides[idir];
+            const Real factor = 0.5 * m_one_over_dx[idir];
+            Real *out = &a_d1(bit(), a_out_comp + idir);
+            for (int i = 0; i < length; i++)
+            {
+                out[i] = (in[i + s] - in[i - s]) * factor;
+            }
+        }
+    }
+}
+
+void DerivativeOperators::scalar_Laplacian(FArrayBox &a_laplacian,
+                                           const int a_out_comp,
+                                           const FArrayBox &a_vars_box,
+                                           const int a_comp,
+                                           const Box &a_box) const
+{
+    CH_assert(a_vars_box.box().size() == m_box_size);
+    CH_assert(a_vars_box.box().contains(grow(a_box, 1)));
+    CH_assert(a_laplacian.box().contains(a_box));
+
+    // the first cell of each row in the unit stride direction
+    Box row_starts = a_box;
+    row_starts.setBig(0, a_box.smallEnd(0));
+    const int length = a_box.size(0);
+    BoxIterator bit(row_starts);
+    for (bit.begin(); bit.ok(); ++bit)
+    {
+        const Real *in = &a_vars_box(bit(), a_comp);
+        Real *out = &a_laplacian(bit(), a_out_comp);
+        for (int i = 0; i < length; i++)
+        {
+            // 2nd order stencil
+            Real laplacian = 0.0;
+            FOR1(idir)
+            {
+                const int s = m_strides[idir];
+                laplacian += (in[i + s] - 2.0 * in[i] + in[i - s]) *
+                             m_one_over_dx2[idir];
+            }
+            out[i] = laplacian;
+        }
+    }
+}
@@ -6,6 +6,7 @@
 #ifndef DERIVATIVEOPERATORS_HPP_
 #define DERIVATIVEOPERATORS_HPP_
 
+#include "Box.H"
 #include "DimensionDefinitions.hpp"
 #include "FArrayBox.H"
 #include "IntVect.H"
@@ -16,32 +17,65 @@
 #include "Tensor.hpp"
 #include "UsingNamespace.H"
 
+// The operators work on the data of FArrayBoxes defined on a_box (or on
+// boxes of the same size), whose memory strides are computed once here.
+// An object is made per box, so it can be used by one thread at a time.
 class DerivativeOperators
 {
   public:
-    DerivativeOperators(const RealVect &a_dx) : m_dx(a_dx){};
+    DerivativeOperators(const RealVect &a_dx, const Box &a_box)
+    {
+        FOR1(idir)
+        {
+            m_one_over_dx[idir] = 1.0 / a_dx[idir];
+            m_one_over_dx2[idir] = 1.0 / (a_dx[idir] * a_dx[idir]);
+        }
+        m_box_size = a_box.size();
+        m_strides[0] = 1;
+        for (int idir = 1; idir < SpaceDim; idir++)
+        {
+            m_strides[idir] = m_strides[idir - 1] * m_box_size[idir - 1];
+        }
+    };
 
     void get_d1(Tensor<1, Real, SpaceDim> &d1, const IntVect &a_iv,
-                const FArrayBox &a_vars_box, const int icomp);
+                const FArrayBox &a_vars_box, const int icomp) const;
 
     void get_d2(Tensor<2, Real, SpaceDim> &d2, const IntVect &a_iv,
-                const FArrayBox &a_vars_box, const int icomp);
+                const FArrayBox &a_vars_box, const int icomp) const;
 
     void get_d1_vector(Tensor<2, Real, SpaceDim> &d1, const IntVect &a_iv,
-                       const FArrayBox &a_vars_box, const Interval &a_interval);
+                       const FArrayBox &a_vars_box,
+                       const Interval &a_interval) const;
 
     void get_d2_vector(Tensor<3, Real, SpaceDim> &d2, const IntVect &a_iv,
-                       const FArrayBox &a_vars_box, const Interval &a_interval);
+                       const FArrayBox &a_vars_box,
+                       const Interval &a_interval) const;
 
     void scalar_Laplacian(Real &laplacian, const IntVect &a_iv,
-                          const FArrayBox &a_vars_box, const int a_comp);
+                          const FArrayBox &a_vars_box, const int a_comp) const;
 
     void vector_Laplacian(Tensor<1, Real, SpaceDim> &laplacian,
                           const IntVect &a_iv, const FArrayBox &a_vars_box,
-                          const Interval &a_interval);
+                          const Interval &a_interval) const;
+
+    // Box versions, which fill the values over the whole of a_box starting
+    // at a_out_comp. The inner loops run along the unit stride direction so
+    // the compiler can vectorise them.
+    void get_d1(FArrayBox &a_d1, const int a_out_comp,
+                const FArrayBox &a_vars_box, const int a_comp,
+                const Box &a_box) const;
+
+    void scalar_Laplacian(FArrayBox &a_laplacian, const int a_out_comp,
+                          const FArrayBox &a_vars_box, const int a_comp,
+                          const Box &a_box) const;
 
   private:
-    const RealVect m_dx;
+    RealVect m_one_over_dx;
+    RealVect m_one_over_dx2;
+    // the offsets in memory to the neighbouring cells in each direction
+    IntVect m_box_size;
+    IntVect m_strides;
 };
 
 #endif /* DERIVATIVEOPERATORS_HPP_ */
@@ -21,37 +21,105 @@
 // Global BCRS definitions
 bool GlobalBCRS::s_areBCsParsed = false;
 BoundaryConditions::params_t GlobalBCRS::s_boundary_params;
+std::map<Box, GlobalBCRS::level_plans_t> GlobalBCRS::s_level_plans;
+
+void GlobalBCRS::define_plans(const Vector<DisjointBoxLayout> &a_grids,
+                              const Vector<ProblemDomain> &a_domains,
+                              const Vector<Real> &a_dx,
+                              const std::vector<int> &a_ghosts)
+{
+    CH_TIME("GlobalBCRS::define_plans");
+
+    if (!s_areBCsParsed)
+    {
+        GRParmParse pp;
+        s_boundary_params.read_params(pp);
+        s_areBCsParsed = true;
+    }
+
+    // the plans of the previous grids are no longer needed
+    s_level_plans.clear();
+
+    for (int ilev = 0; ilev < a_grids.size(); ilev++)
+    {
+        // the coarsenings that VariableCoeffPoissonOperatorFactory::MGnewOp
+        // makes operators for
+        for (int coarsening = 1;
+             coarsening == 1 ||
+             a_grids[ilev].coarsenable(
+                 coarsening * VariableCoeffPoissonOperator::s_maxCoarse);
+             coarsening *= 2)
+        {
+            ProblemDomain domain = a_domains[ilev];
+            domain.coarsen(coarsening);
+            DisjointBoxLayout layout;
+            coarsen_dbl(layout, a_grids[ilev], coarsening);
+
+            // levels coarsened down to the next AMR level share its plans
+            const Box &domain_box = domain.domainBox();
+            auto level_it = s_level_plans.find(domain_box);
+            if (level_it == s_level_plans.end())
+            {
+                level_it =
+                    s_level_plans.emplace(domain_box, level_plans_t()).first;
+                int num_ghosts = 1;
+                level_it->second.boundaries.define(a_dx[ilev] * coarsening,
+                                                   s_boundary_params, domain,
+                                                   num_ghosts);
+            }
+            level_plans_t &level_plans = level_it->second;
+
+            // only the boxes of this rank are filled here
+            for (DataIterator dit = layout.dataIterator(); dit.ok(); ++dit)
+            {
+                for (int ghosts : a_ghosts)
+                {
+                    Box state_box = grow(layout[dit], ghosts);
+                    if (!domain_box.contains(state_box))
+                    {
+                        level_plans.boundaries.get_constraint_fill_plan(
+                            level_plans.box_plans[state_box], state_box);
+                    }
+                }
+            }
+        }
+    }
+}
 
 void ParseBC(FArrayBox &a_state, const Box &a_valid,
              const ProblemDomain &a_domain, Real a_dx, bool a_homogeneous)
 {
     if (!a_domain.domainBox().contains(a_state.box()))
     {
-        if (!GlobalBCRS::s_areBCsParsed)
+        // This is called for every box on every smoothing step, so the
+        // plans are built in advance by GlobalBCRS::define_plans and only
+        // looked up here
+        auto level_it = GlobalBCRS::s_level_plans.find(a_domain.domainBox());
+        if (level_it == GlobalBCRS::s_level_plans.end())
         {
-            GRParmParse pp;
-            GlobalBCRS::s_boundary_params.read_params(pp);
-            GlobalBCRS::s_areBCsParsed = true;
+            MayDay::Error("ParseBC: no boundary plans for this level, "
+                          "GlobalBCRS::define_plans must be called first");
         }
+        const GlobalBCRS::level_plans_t &level_plans = level_it->second;
 
-        // fill the boundary cells and ghosts
-        BoundaryConditions solver_boundaries;
-        int num_ghosts = 1;
-        std::array<double, 3> center = {0.0, 0.0, 0.0};
-        solver_boundaries.define(a_dx, GlobalBCRS::s_boundary_params, a_domain,
-                                 num_ghosts);
-
-        // this will populate the multigrid boundaries according to the BCs
-        // in particular it will fill cells for Aij, and updated K
-        solver_boundaries.fill_constraint_box(
-            Side::Lo, a_state, Interval(0, NUM_CONSTRAINT_VARS - 1));
-        solver_boundaries.fill_constraint_box(
-            Side::Hi, a_state, Interval(0, NUM_CONSTRAINT_VARS - 1));
-        // Do it twice to catch corners... must be a better way
-        // but for now this works
-        solver_boundaries.fill_constraint_box(
-            Side::Lo, a_state, Interval(0, NUM_CONSTRAINT_VARS - 1));
-        solver_boundaries.fill_constraint_box(
-            Side::Hi, a_state, Interval(0, NUM_CONSTRAINT_VARS - 1));
+        // this will populate the boundary cells of the constraint vars
+        // according to the BCs, including the edges and corners
+        const Interval comps(0, NUM_CONSTRAINT_VARS - 1);
+        auto plan_it = level_plans.box_plans.find(a_state.box());
+        if (plan_it != level_plans.box_plans.end())
+        {
+            level_plans.boundaries.fill_constraint_box(a_state,
+                                                       plan_it->second, comps);
+        }
+        else
+        {
+            // a ghost width that was not planned for, which is not cached
+            // so that the plans are never modified here
+            BoundaryConditions::fill_plan_t fill_plan;
+            level_plans.boundaries.get_constraint_fill_plan(fill_plan,
+                                                            a_state.box());
+            level_plans.boundaries.fill_constraint_box(a_state, fill_plan,
+                                                       comps);
+        }
     }
 }
@@ -21,12 +21,23 @@
 #include "InterpF_F.H"
 #include "LayoutIterator.H"
 #include "Misc.H"
+#include "SPMD.H"
+#include "SetBCs.H"
 #include "VariableCoeffPoissonOperatorF_F.H"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 
 #include "NamespaceHeader.H"
 
 // This file implements the key functions for the multi grid methods
 
+bool VariableCoeffPoissonOperator::s_interleavedGSRB = false;
+bool VariableCoeffPoissonOperator::s_chebyshevSmoother = false;
+bool VariableCoeffPoissonOperator::s_singlePrecisionSmoother = false;
+bool VariableCoeffPoissonOperator::s_directBottomSolve = false;
+int VariableCoeffPoissonOperator::s_maxDirectBottomCells = 1024;
+
 void VariableCoeffPoissonOperator::residualI(
     LevelData<FArrayBox> &a_lhs, const LevelData<FArrayBox> &a_constraint_vars,
     const LevelData<FArrayBox> &a_rhs, bool a_homogeneous)
@@ -49,9 +60,12 @@ void VariableCoeffPoissonOperator::residualI(
 
     constraint_vars.exchange(constraint_vars.interval(), m_exchangeCopier);
 
-    for (dit.begin(); dit.ok(); ++dit)
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
     {
-        const Box &region = dbl[dit()];
+        DataIndex dind = dit[ibox];
+        const Box &region = dbl[dind];
 
 #if CH_SPACEDIM == 1
         FORT_VCCOMPUTERES1D
@@ -62,10 +76,10 @@ void VariableCoeffPoissonOperator::residualI(
 #else
         This_will_not_compile !
 #endif
-            (CHF_FRA(a_lhs[dit]), CHF_CONST_FRA(constraint_vars[dit]),
-             CHF_CONST_FRA(a_rhs[dit]), CHF_CONST_REAL(m_alpha),
-             CHF_CONST_FRA((*m_aCoef)[dit]), CHF_CONST_REAL(m_beta),
-             CHF_CONST_FRA((*m_bCoef)[dit]), CHF_BOX(region),
+            (CHF_FRA(a_lhs[dind]), CHF_CONST_FRA(constraint_vars[dind]),
+             CHF_CONST_FRA(a_rhs[dind]), CHF_CONST_REAL(m_alpha),
+             CHF_CONST_FRA((*m_aCoef)[dind]), CHF_CONST_REAL(m_beta),
+             CHF_CONST_FRA((*m_bCoef)[dind]), CHF_BOX(region),
              CHF_CONST_REAL(m_dx));
     } // end loop over boxes
 }
@@ -94,6 +108,15 @@ void VariableCoeffPoissonOperator::preCond(
     // Recompute the relaxation coefficient if needed.
     resetLambda();
 
+    // On the coarsest level this is the preconditioner of the bottom
+    // solver, so solving exactly means it converges in one iteration
+    if (m_isBottom && s_directBottomSolve &&
+        m_domain.domainBox().numPts() <= s_maxDirectBottomCells)
+    {
+        bottomSolve(a_constraint_vars, a_rhs);
+        return;
+    }
+
     // don't need to use a Copier -- plain copy will do
     DataIterator dit = a_constraint_vars.dataIterator();
     for (dit.begin(); dit.ok(); ++dit)
@@ -245,35 +268,361 @@ void VariableCoeffPoissonOperator::resetLambda()
 
     if (m_lambdaNeedsResetting)
     {
+        CH_TIME("VariableCoeffPoissonOperator::resetLambda");
 
-        Real scale = 1.0 / (m_dx * m_dx);
+        int ncomp = m_lambda.nComp();
 
         // Compute it box by box, point by point
-        for (DataIterator dit = m_lambda.dataIterator(); dit.ok(); ++dit)
+        DataIterator dit = m_lambda.dataIterator();
+        int nbox = dit.size();
+#pragma omp parallel for default(shared)
+        for (int ibox = 0; ibox < nbox; ++ibox)
         {
-            FArrayBox &lambdaFab = m_lambda[dit];
-            const FArrayBox &aCoefFab = (*m_aCoef)[dit];
-            const FArrayBox &bCoefFab = (*m_bCoef)[dit];
-            const Box &curBox = lambdaFab.box();
-
-            // Compute the diagonal term
-            lambdaFab.copy(aCoefFab);
-            lambdaFab.mult(m_alpha);
-
-            // Add in the Laplacian term 6.0*m_beta/(m_dx*m_dx)
-            // KC TODO: Should implement other adjustments for NL terms,
-            // but appears to converge without
-            lambdaFab.plus(2.0 * SpaceDim * m_beta / (m_dx * m_dx));
+            DataIndex dind = dit[ibox];
+            FArrayBox &lambdaFab = m_lambda[dind];
+            const FArrayBox &aCoefFab = (*m_aCoef)[dind];
+            const FArrayBox &bCoefFab = (*m_bCoef)[dind];
+
+            // The diagonal of the operator is
+            // alpha * aCoef + 2 * SpaceDim * beta * bCoef / dx^2
+            // where the linearised nonlinear terms (in psi) are already
+            // included in aCoef by the methods
+            lambdaFab.copy(bCoefFab);
+            lambdaFab.mult(2.0 * SpaceDim * m_beta / (m_dx * m_dx));
+            lambdaFab.plus(aCoefFab, m_alpha, 0, 0, ncomp);
 
             // Take its reciprocal
             lambdaFab.invert(1.0);
         }
 
+        if (s_singlePrecisionSmoother)
+        {
+            setSingleCoefs();
+        }
+
+        if (s_chebyshevSmoother)
+        {
+            setChebyshevBound();
+        }
+
+        // the bottom factorisation is out of date too
+        m_bottomFactorised = false;
+
         // Lambda is reset.
         m_lambdaNeedsResetting = false;
     }
 }
 
+void VariableCoeffPoissonOperator::setChebyshevBound()
+{
+    CH_TIME("VariableCoeffPoissonOperator::setChebyshevBound");
+
+    // Each row of lambda * L has 1 on the diagonal and 2 * SpaceDim
+    // off-diagonal entries of size |lambda * beta * bCoef| / dx^2, so by
+    // Gershgorin the spectrum lies below 1 plus their sum. This is 2 when
+    // alpha * aCoef has the same sign as the Laplacian term, but can be
+    // larger when it has the opposite sign.
+    int ncomp = m_lambda.nComp();
+    Real off_diag_factor = 2.0 * SpaceDim * std::abs(m_beta) / (m_dx * m_dx);
+
+    DataIterator dit = m_lambda.dataIterator();
+    int nbox = dit.size();
+    std::vector<Real> box_max(nbox, 0.0);
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
+    {
+        DataIndex dind = dit[ibox];
+        const FArrayBox &lambdaFab = m_lambda[dind];
+        const FArrayBox &bCoefFab = (*m_bCoef)[dind];
+        BoxIterator bit(lambdaFab.box());
+        for (bit.begin(); bit.ok(); ++bit)
+        {
+            IntVect iv = bit();
+            for (int comp = 0; comp < ncomp; comp++)
+            {
+                Real radius = std::abs(lambdaFab(iv, comp) *
+                                       bCoefFab(iv, comp)) *
+                              off_diag_factor;
+                box_max[ibox] = std::max(box_max[ibox], radius);
+            }
+        }
+    }
+
+    Real max_radius = 0.0;
+    for (int ibox = 0; ibox < nbox; ++ibox)
+    {
+        max_radius = std::max(max_radius, box_max[ibox]);
+    }
+#ifdef CH_MPI
+    Real local_max = max_radius;
+    MPI_Allreduce(&local_max, &max_radius, 1, MPI_CH_REAL, MPI_MAX,
+                  Chombo_MPI::comm);
+#endif
+
+    m_chebyshevUpper = 1.0 + max_radius;
+}
+
+void VariableCoeffPoissonOperator::setSingleCoefs()
+{
+    CH_TIME("VariableCoeffPoissonOperator::setSingleCoefs");
+
+    int ncomp = m_lambda.nComp();
+    if (!m_singleCoefs.isDefined())
+    {
+        m_singleCoefs.define(m_lambda.disjointBoxLayout());
+    }
+
+    DataIterator dit = m_lambda.dataIterator();
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
+    {
+        DataIndex dind = dit[ibox];
+        const FArrayBox &lambdaFab = m_lambda[dind];
+        const FArrayBox &aCoefFab = (*m_aCoef)[dind];
+        const FArrayBox &bCoefFab = (*m_bCoef)[dind];
+        const Box &box = lambdaFab.box();
+
+        // alpha * aCoef, beta * bCoef / dx^2 and lambda for each component
+        BaseFab<float> &coefs = m_singleCoefs[dind];
+        coefs.resize(box, 3 * ncomp);
+        for (int n = 0; n < ncomp; n++)
+        {
+            BoxIterator bit(box);
+            for (bit.begin(); bit.ok(); ++bit)
+            {
+                IntVect iv = bit();
+                coefs(iv, n) = m_alpha * aCoefFab(iv, n);
+                coefs(iv, ncomp + n) =
+                    m_beta * bCoefFab(iv, n) / (m_dx * m_dx);
+                coefs(iv, 2 * ncomp + n) = lambdaFab(iv, n);
+            }
+        }
+    }
+}
+
+void VariableCoeffPoissonOperator::factoriseBottom()
+{
+    CH_TIME("VariableCoeffPoissonOperator::factoriseBottom");
+
+    // the boundary params are read in ParseBC, which the residual calls
+    // before the bottom solver gets here
+    CH_assert(GlobalBCRS::s_areBCsParsed);
+    const BoundaryConditions::params_t &bc_params =
+        GlobalBCRS::s_boundary_params;
+
+    // the whole level on a single box on rank 0
+    const Box &domain_box = m_domain.domainBox();
+    Vector<Box> boxes(1, domain_box);
+    Vector<int> procs(1, 0);
+    m_bottomLayout = DisjointBoxLayout(boxes, procs, m_domain);
+
+    int ncomp = m_aCoef->nComp();
+    LevelData<FArrayBox> aCoef(m_bottomLayout, ncomp);
+    LevelData<FArrayBox> bCoef(m_bottomLayout, ncomp);
+    m_aCoef->copyTo(m_aCoef->interval(), aCoef, aCoef.interval());
+    m_bCoef->copyTo(m_bCoef->interval(), bCoef, bCoef.interval());
+
+    m_bottomLU.assign(ncomp, std::vector<Real>());
+    m_bottomPivots.assign(ncomp, std::vector<int>());
+    m_bottomSolvable.assign(ncomp, false);
+
+    const IntVect size = domain_box.size();
+    const int ncells = domain_box.numPts();
+    const Real dx2inv = 1.0 / (m_dx * m_dx);
+
+    for (DataIterator dit = aCoef.dataIterator(); dit.ok(); ++dit)
+    {
+        for (int n = 0; n < ncomp; n++)
+        {
+            // Build the matrix of L for component n, with the cells in the
+            // same order as in the FArrayBox, and the (homogeneous) boundary
+            // conditions of ParseBC folded in
+            std::vector<Real> &A = m_bottomLU[n];
+            A.assign((size_t)ncells * ncells, 0.0);
+            BoxIterator bit(domain_box);
+            for (bit.begin(); bit.ok(); ++bit)
+            {
+                const IntVect iv = bit();
+                const int row = domain_box.index(iv);
+                const Real b_term = m_beta * bCoef[dit](iv, n) * dx2inv;
+                A[(size_t)row * ncells + row] +=
+                    m_alpha * aCoef[dit](iv, n) + 2.0 * SpaceDim * b_term;
+
+                for (int idir = 0; idir < SpaceDim; idir++)
+                {
+                    for (SideIterator sit; sit.ok(); ++sit)
+                    {
+                        IntVect neighbour = iv + sign(sit()) * BASISV(idir);
+                        Real factor = 1.0;
+                        if (!domain_box.contains(neighbour))
+                        {
+                            if (bc_params.is_periodic[idir])
+                            {
+                                neighbour[idir] += (sit() == Side::Lo)
+                                                       ? size[idir]
+                                                       : -size[idir];
+                            }
+                            else
+                            {
+                                // the ghost is set from this cell
+                                neighbour = iv;
+                                int bc = (sit() == Side::Lo)
+                                             ? bc_params.lo_boundary[idir]
+                                             : bc_params.hi_boundary[idir];
+                                if (bc == BoundaryConditions::REFLECTIVE_BC)
+                                {
+                                    factor = BoundaryConditions::get_var_parity(
+                                        n, idir, bc_params,
+                                        VariableType::constraint);
+                                }
+                                else if (n != c_psi &&
+                                         bc_params.Vi_extrapolated_at_boundary)
+                                {
+                                    factor = 1.0;
+                                }
+                                else
+                                {
+                                    factor = -1.0;
+                                }
+                            }
+                        }
+                        const int col = domain_box.index(neighbour);
+                        A[(size_t)row * ncells + col] -= factor * b_term;
+                    }
+                }
+            }
+
+            // LU factorisation with partial pivoting, in place
+            std::vector<int> &pivots = m_bottomPivots[n];
+            pivots.resize(ncells);
+            Real max_diag = 0.0;
+            for (int i = 0; i < ncells; i++)
+            {
+                max_diag = std::max(max_diag,
+                                    std::abs(A[(size_t)i * ncells + i]));
+            }
+            bool solvable = true;
+            for (int k = 0; k < ncells && solvable; k++)
+            {
+                int pivot = k;
+                for (int i = k + 1; i < ncells; i++)
+                {
+                    if (std::abs(A[(size_t)i * ncells + k]) >
+                        std::abs(A[(size_t)pivot * ncells + k]))
+                    {
+                        pivot = i;
+                    }
+                }
+                pivots[k] = pivot;
+                // (nearly) singular, e.g. a periodic Laplacian
+                if (std::abs(A[(size_t)pivot * ncells + k]) <=
+                    1e-12 * max_diag)
+                {
+                    solvable = false;
+                    break;
+                }
+                if (pivot != k)
+                {
+                    std::swap_ranges(A.begin() + (size_t)k * ncells,
+                                     A.begin() + (size_t)(k + 1) * ncells,
+                                     A.begin() + (size_t)pivot * ncells);
+                }
+                const Real *row_k = &A[(size_t)k * ncells];
+                for (int i = k + 1; i < ncells; i++)
+                {
+                    Real *row_i = &A[(size_t)i * ncells];
+                    const Real l_ik = row_i[k] / row_k[k];
+                    row_i[k] = l_ik;
+                    if (l_ik != 0.0)
+                    {
+                        for (int j = k + 1; j < ncells; j++)
+                        {
+                            row_i[j] -= l_ik * row_k[j];
+                        }
+                    }
+                }
+            }
+            m_bottomSolvable[n] = solvable;
+            if (!solvable)
+            {
+                A.clear();
+                pivots.clear();
+            }
+        }
+    }
+
+    m_bottomFactorised = true;
+}
+
+void VariableCoeffPoissonOperator::bottomSolve(
+    LevelData<FArrayBox> &a_correction, const LevelData<FArrayBox> &a_rhs)
+{
+    CH_TIME("VariableCoeffPoissonOperator::bottomSolve");
+
+    if (!m_bottomFactorised)
+    {
+        factoriseBottom();
+    }
+
+    // gather the level onto rank 0
+    int ncomp = a_rhs.nComp();
+    LevelData<FArrayBox> gathered(m_bottomLayout, ncomp);
+    LevelData<FArrayBox> lambda(m_bottomLayout, ncomp);
+    a_rhs.copyTo(a_rhs.interval(), gathered, gathered.interval());
+    m_lambda.copyTo(m_lambda.interval(), lambda, lambda.interval());
+
+    for (DataIterator dit = gathered.dataIterator(); dit.ok(); ++dit)
+    {
+        const int ncells = gathered[dit].box().numPts();
+        for (int n = 0; n < ncomp; n++)
+        {
+            Real *x = gathered[dit].dataPtr(n);
+            if (!m_bottomSolvable[n])
+            {
+                // fall back to the diagonal approximation
+                const Real *lambda_n = lambda[dit].dataPtr(n);
+                for (int i = 0; i < ncells; i++)
+                {
+                    x[i] *= lambda_n[i];
+                }
+                continue;
+            }
+
+            const std::vector<Real> &LU = m_bottomLU[n];
+            const std::vector<int> &pivots = m_bottomPivots[n];
+            for (int k = 0; k < ncells; k++)
+            {
+                std::swap(x[k], x[pivots[k]]);
+            }
+            for (int i = 1; i < ncells; i++)
+            {
+                const Real *row_i = &LU[(size_t)i * ncells];
+                Real sum = x[i];
+                for (int j = 0; j < i; j++)
+                {
+                    sum -= row_i[j] * x[j];
+                }
+                x[i] = sum;
+            }
+            for (int i = ncells - 1; i >= 0; i--)
+            {
+                const Real *row_i = &LU[(size_t)i * ncells];
+                Real sum = x[i];
+                for (int j = i + 1; j < ncells; j++)
+                {
+                    sum -= row_i[j] * x[j];
+                }
+                x[i] = sum / row_i[i];
+            }
+        }
+    }
+
+    // and scatter the solution back
+    gathered.copyTo(gathered.interval(), a_correction,
+                    a_correction.interval());
+}
+
 // Compute the reciprocal of the diagonal entry of the operator matrix
 void VariableCoeffPoissonOperator::computeLambda()
 {
@@ -347,23 +696,132 @@ void VariableCoeffPoissonOperator::levelGSRB(
         for (dit.begin(); dit.ok(); ++dit)
         {
             const Box &region = dbl.get(dit());
+            GSRBRegion(a_constraint_vars[dit], a_rhs[dit], region, dit(),
+                       whichPass);
+        } // end loop through grids
+    }     // end loop through red-black
+}
+
+void VariableCoeffPoissonOperator::GSRBRegion(FArrayBox &a_constraint_vars,
+                                              const FArrayBox &a_rhs,
+                                              const Box &a_region,
+                                              const DataIndex &a_index,
+                                              int a_whichPass)
+{
+    if (s_interleavedGSRB || s_singlePrecisionSmoother)
+    {
+        GSRBRegionInterleaved(a_constraint_vars, a_rhs, a_region, a_index,
+                              a_whichPass);
+        return;
+    }
 
 #if CH_SPACEDIM == 1
-            FORT_GSRBHELMHOLTZVC1D
+    FORT_GSRBHELMHOLTZVC1D
 #elif CH_SPACEDIM == 2
-            FORT_GSRBHELMHOLTZVC2D
+    FORT_GSRBHELMHOLTZVC2D
 #elif CH_SPACEDIM == 3
-            FORT_GSRBHELMHOLTZVC3D
+    FORT_GSRBHELMHOLTZVC3D
 #else
-            This_will_not_compile !
+    This_will_not_compile !
 #endif
-                (CHF_FRA(a_constraint_vars[dit]), CHF_CONST_FRA(a_rhs[dit]),
-                 CHF_BOX(region), CHF_CONST_REAL(m_dx), CHF_CONST_REAL(m_alpha),
-                 CHF_CONST_FRA((*m_aCoef)[dit]), CHF_CONST_REAL(m_beta),
-                 CHF_CONST_FRA((*m_bCoef)[dit]), CHF_CONST_FRA(m_lambda[dit]),
-                 CHF_CONST_INT(whichPass));
-        } // end loop through grids
-    }     // end loop through red-black
+        (CHF_FRA(a_constraint_vars), CHF_CONST_FRA(a_rhs), CHF_BOX(a_region),
+         CHF_CONST_REAL(m_dx), CHF_CONST_REAL(m_alpha),
+         CHF_CONST_FRA((*m_aCoef)[a_index]), CHF_CONST_REAL(m_beta),
+         CHF_CONST_FRA((*m_bCoef)[a_index]), CHF_CONST_FRA(m_lambda[a_index]),
+         CHF_CONST_INT(a_whichPass));
+}
+
+// One colour of GSRB along a row, where the operator is
+// a_fac * a * phi - b_fac * b * (Laplacian stencil of phi), so that the
+// coefficients can be stored in either precision
+template <typename coef_t>
+static inline void gsrb_row(Real *phi, const Real *rhs, const coef_t *a,
+                            const coef_t *b, const coef_t *lam,
+                            const Real a_fac, const Real b_fac, const int ni,
+                            const int sy, const int sz)
+{
+    // cells of one colour do not depend on each other
+#pragma omp simd
+    for (int i = 0; i <= ni; i += 2)
+    {
+        const Real lap_phi = phi[i + 1] + phi[i - 1] + phi[i + sy] +
+                             phi[i - sy] + phi[i + sz] + phi[i - sz] -
+                             6.0 * phi[i];
+        const Real L_phi = a_fac * a[i] * phi[i] - b_fac * b[i] * lap_phi;
+        phi[i] -= lam[i] * (L_phi - rhs[i]);
+    }
+}
+
+void VariableCoeffPoissonOperator::GSRBRegionInterleaved(
+    FArrayBox &a_constraint_vars, const FArrayBox &a_rhs, const Box &a_region,
+    const DataIndex &a_index, int a_whichPass)
+{
+    CH_assert(SpaceDim == 3);
+
+    const FArrayBox &aCoef = (*m_aCoef)[a_index];
+    const FArrayBox &bCoef = (*m_bCoef)[a_index];
+    const FArrayBox &lambda = m_lambda[a_index];
+    const int ncomp = a_constraint_vars.nComp();
+    const Real dxinv = 1.0 / (m_dx * m_dx);
+
+    // offsets to the neighbouring cells in the y and z directions
+    const Box &phi_box = a_constraint_vars.box();
+    const int sy = phi_box.size(0);
+    const int sz = phi_box.size(0) * phi_box.size(1);
+
+    // The components are smoothed one row at a time, rather than one box at
+    // a time, and the rows are taken in blocks of j and k so that the
+    // neighbouring rows are still in cache when they are needed again
+    const int block_size = 8;
+    const IntVect &lo = a_region.smallEnd();
+    const IntVect &hi = a_region.bigEnd();
+    for (int kb = lo[2]; kb <= hi[2]; kb += block_size)
+    {
+        const int k_end = std::min(kb + block_size - 1, hi[2]);
+        for (int jb = lo[1]; jb <= hi[1]; jb += block_size)
+        {
+            const int j_end = std::min(jb + block_size - 1, hi[1]);
+            for (int k = kb; k <= k_end; k++)
+            {
+                for (int j = jb; j <= j_end; j++)
+                {
+                    // start on the cell where i + j + k has the parity of
+                    // the pass, as in the Fortran
+                    const int imin =
+                        lo[0] + std::abs((lo[0] + j + k + a_whichPass) % 2);
+                    if (imin > hi[0])
+                    {
+                        continue;
+                    }
+                    const int ni = hi[0] - imin;
+                    const IntVect row_start(imin, j, k);
+
+                    for (int n = 0; n < ncomp; n++)
+                    {
+                        Real *phi = &a_constraint_vars(row_start, n);
+                        const Real *rhs = &a_rhs(row_start, n);
+                        if (s_singlePrecisionSmoother)
+                        {
+                            // alpha, beta and dx are already folded in
+                            const BaseFab<float> &coefs =
+                                m_singleCoefs[a_index];
+                            gsrb_row(phi, rhs, &coefs(row_start, n),
+                                     &coefs(row_start, ncomp + n),
+                                     &coefs(row_start, 2 * ncomp + n), 1.0,
+                                     1.0, ni, sy, sz);
+                        }
+                        else
+                        {
+                            gsrb_row(phi, rhs, &aCoef(row_start, n),
+                                     &bCoef(row_start, n),
+                                     &lambda(row_start, n), m_alpha,
+                                     m_beta * dxinv, ni, sy, sz);
+                        }
+                    }
+                }
+            }
+        }
+    }
 }
 
 void VariableCoeffPoissonOperator::levelMultiColor(
@@ -385,8 +843,92 @@ void VariableCoeffPoissonOperator::overlapGSRB(
     LevelData<FArrayBox> &a_constraint_vars, const LevelData<FArrayBox> &a_rhs)
 {
     CH_TIME("VariableCoeffPoissonOperator::overlapGSRB");
-    MayDay::Abort(
-        "VariableCoeffPoissonOperator::overlapGSRB - Not implemented");
+
+    CH_assert(a_constraint_vars.isDefined());
+    CH_assert(a_rhs.isDefined());
+    CH_assert(a_constraint_vars.ghostVect() >= IntVect::Unit);
+    CH_assert(a_constraint_vars.nComp() == a_rhs.nComp());
+
+    // Recompute the relaxation coefficient if needed.
+    resetLambda();
+
+    const DisjointBoxLayout &dbl = a_constraint_vars.disjointBoxLayout();
+
+    DataIterator dit = a_constraint_vars.dataIterator();
+
+    // Same as levelGSRB, but the cells whose stencils do not reach the ghosts
+    // are smoothed while the exchange is in progress. Cells of one colour do
+    // not depend on each other, so the result is the same.
+    for (int whichPass = 0; whichPass <= 1; whichPass++)
+    {
+        CH_TIMERS("VariableCoeffPoissonOperator::overlapGSRB::Compute");
+
+        // fill in intersection of ghostcells and a_constraint_vars's boxes
+        {
+            CH_TIME("VariableCoeffPoissonOperator::overlapGSRB::"
+                    "homogeneousCFInterp");
+            homogeneousCFInterp(a_constraint_vars);
+        }
+
+        // the data to send is copied out here, so the valid cells can be
+        // updated before the exchange is finished
+        {
+            CH_TIME("VariableCoeffPoissonOperator::overlapGSRB::"
+                    "exchangeBegin");
+            a_constraint_vars.exchangeBegin(m_exchangeCopier);
+        }
+
+        {
+            CH_TIME("VariableCoeffPoissonOperator::overlapGSRB::interior");
+            for (dit.begin(); dit.ok(); ++dit)
+            {
+                Box interior = dbl.get(dit());
+                interior.grow(-1);
+                if (!interior.isEmpty())
+                {
+                    GSRBRegion(a_constraint_vars[dit], a_rhs[dit], interior,
+                               dit(), whichPass);
+                }
+            }
+        }
+
+        {
+            CH_TIME("VariableCoeffPoissonOperator::overlapGSRB::exchangeEnd");
+            a_constraint_vars.exchangeEnd();
+        }
+
+        {
+            CH_TIME("VariableCoeffPoissonOperator::overlapGSRB::BCs");
+            for (dit.begin(); dit.ok(); ++dit)
+            {
+                // invoke physical BC's where necessary
+                m_bc(a_constraint_vars[dit], dbl[dit()], m_domain, m_dx, true);
+            }
+        }
+
+        // now the shell of cells next to the ghosts, split into slabs so
+        // that each cell is only visited once
+        for (dit.begin(); dit.ok(); ++dit)
+        {
+            Box remaining = dbl.get(dit());
+            for (int idir = 0; idir < SpaceDim && !remaining.isEmpty(); idir++)
+            {
+                Box lo_slab = remaining;
+                lo_slab.setBig(idir, remaining.smallEnd(idir));
+                GSRBRegion(a_constraint_vars[dit], a_rhs[dit], lo_slab, dit(),
+                           whichPass);
+
+                if (remaining.size(idir) > 1)
+                {
+                    Box hi_slab = remaining;
+                    hi_slab.setSmall(idir, remaining.bigEnd(idir));
+                    GSRBRegion(a_constraint_vars[dit], a_rhs[dit], hi_slab,
+                               dit(), whichPass);
+                }
+                remaining.grow(idir, -1);
+            }
+        } // end loop through grids
+    }     // end loop through red-black
 }
 
 void VariableCoeffPoissonOperator::levelGSRBLazy(
@@ -406,26 +948,130 @@ void VariableCoeffPoissonOperator::levelJacobi(
     // Recompute the relaxation coefficient if needed.
     resetLambda();
 
-    LevelData<FArrayBox> resid;
-    create(resid, a_rhs);
+    defineSmootherScratch(a_rhs);
 
     // Get the residual
-    residual(resid, a_constraint_vars, a_rhs, true);
+    residual(m_smootherResid, a_constraint_vars, a_rhs, true);
 
-    // Multiply by the weights
+    // Multiply by the weights and do the Jacobi relaxation
+    int ncomp = a_constraint_vars.nComp();
     DataIterator dit = m_lambda.dataIterator();
-    for (dit.begin(); dit.ok(); ++dit)
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
     {
-        resid[dit].mult(m_lambda[dit]);
+        DataIndex dind = dit[ibox];
+        m_smootherResid[dind].mult(m_lambda[dind]);
+        a_constraint_vars[dind].plus(m_smootherResid[dind], 0.5, 0, 0, ncomp);
     }
 
-    // Do the Jacobi relaxation
-    incr(a_constraint_vars, resid, 0.5);
-
     // exchange ghost cells
     a_constraint_vars.exchange(a_constraint_vars.interval(), m_exchangeCopier);
 }
 
+void VariableCoeffPoissonOperator::levelChebyshev(
+    LevelData<FArrayBox> &a_constraint_vars, const LevelData<FArrayBox> &a_rhs,
+    int a_degree)
+{
+    CH_TIME("VariableCoeffPoissonOperator::levelChebyshev");
+
+    // Recompute the relaxation coefficient if needed.
+    resetLambda();
+
+    defineSmootherScratch(a_rhs);
+
+    // Chebyshev acceleration of Jacobi, damping the eigenvalues of
+    // lambda * L in [lower, upper]. The upper bound is the Gershgorin one
+    // set with lambda, and a smoother only needs to damp the upper end.
+    const Real upper = m_chebyshevUpper;
+    const Real lower = 0.3 * upper;
+    const Real theta = 0.5 * (upper + lower);
+    const Real delta = 0.5 * (upper - lower);
+    const Real sigma = theta / delta;
+    Real rho = 1.0 / sigma;
+
+    int ncomp = a_constraint_vars.nComp();
+    DataIterator dit = m_lambda.dataIterator();
+    int nbox = dit.size();
+    for (int iter = 0; iter < a_degree; iter++)
+    {
+        // this does the only exchange of the iteration
+        residual(m_smootherResid, a_constraint_vars, a_rhs, true);
+
+        // the new direction is dir_coef * dir + resid_coef * lambda * resid
+        Real dir_coef = 0.0;
+        Real resid_coef = 1.0 / theta;
+        if (iter > 0)
+        {
+            Real rho_new = 1.0 / (2.0 * sigma - rho);
+            dir_coef = rho_new * rho;
+            resid_coef = 2.0 * rho_new / delta;
+            rho = rho_new;
+        }
+
+#pragma omp parallel for default(shared)
+        for (int ibox = 0; ibox < nbox; ++ibox)
+        {
+            DataIndex dind = dit[ibox];
+            FArrayBox &dir = m_smootherDir[dind];
+            const FArrayBox &resid = m_smootherResid[dind];
+            const FArrayBox &lambda = m_lambda[dind];
+            CH_assert(dir.box() == lambda.box());
+            CH_assert(resid.box() == lambda.box());
+
+            if (iter == 0)
+            {
+                dir.setVal(0.0);
+            }
+
+            // the scratch data and lambda have no ghosts, so the boxes are
+            // the same and the data can be run through in one go
+            Real *dir_ptr = dir.dataPtr();
+            const Real *resid_ptr = resid.dataPtr();
+            const Real *lambda_ptr = lambda.dataPtr();
+            const long npts = (long)dir.box().numPts() * ncomp;
+            for (long i = 0; i < npts; i++)
+            {
+                dir_ptr[i] = dir_coef * dir_ptr[i] +
+                             resid_coef * lambda_ptr[i] * resid_ptr[i];
+            }
+
+            a_constraint_vars[dind].plus(dir, 0, 0, ncomp);
+        }
+    }
+
+    // no exchange here, whatever uses the result next fills the ghosts
+}
+
+void VariableCoeffPoissonOperator::relax(LevelData<FArrayBox> &a_e,
+                                         const LevelData<FArrayBox> &a_residual,
+                                         int a_iterations)
+{
+    CH_TIME("VariableCoeffPoissonOperator::relax");
+
+    if (s_chebyshevSmoother)
+    {
+        // a_iterations smoothing steps give a polynomial of that degree
+        levelChebyshev(a_e, a_residual, a_iterations);
+    }
+    else
+    {
+        AMRPoissonOp::relax(a_e, a_residual, a_iterations);
+    }
+}
+
+void VariableCoeffPoissonOperator::defineSmootherScratch(
+    const LevelData<FArrayBox> &a_rhs)
+{
+    if (!m_smootherResid.isDefined())
+    {
+        m_smootherResid.define(a_rhs.disjointBoxLayout(), a_rhs.nComp(),
+                               IntVect::Zero);
+        m_smootherDir.define(a_rhs.disjointBoxLayout(), a_rhs.nComp(),
+                             IntVect::Zero);
+    }
+}
+
 // Removed as only needed for fluxes, may need to reinstate in future,
 // if so see MG examples
 void VariableCoeffPoissonOperator::getFlux(FArrayBox &a_flux,
@@ -49,6 +49,16 @@ defineOperatorFactory(const Vector<DisjointBoxLayout> &a_grids,
             a_grid_params.coefficient_average_type;
     }
 
+    // the boundary plans of the solver vars (with all their ghosts) and of
+    // the multigrid data (with one layer)
+    Vector<Real> vectDx(a_grids.size(), a_grid_params.coarsestDx);
+    for (int ilev = 1; ilev < a_grids.size(); ilev++)
+    {
+        vectDx[ilev] = vectDx[ilev - 1] / a_grid_params.refRatio[ilev - 1];
+    }
+    std::vector<int> ghosts = {1, a_grid_params.num_ghosts};
+    GlobalBCRS::define_plans(a_grids, a_vectDomain, vectDx, ghosts);
+
     return (AMRLevelOpFactory<LevelData<FArrayBox>> *)opFactory;
 }
 
@@ -189,6 +199,12 @@ VariableCoeffPoissonOperatorFactory::MGnewOp(const ProblemDomain &a_indexSpace,
         !m_boxes[ref].coarsenable(coarsening *
                                   VariableCoeffPoissonOperator::s_maxCoarse))
     {
+        // multigrid stops here, so the operators one level up are the
+        // bottom of the coarsest AMR level
+        if (ref == 0)
+        {
+            markBottom(a_depth - 1);
+        }
         return NULL;
     }
 
@@ -213,6 +229,10 @@ VariableCoeffPoissonOperatorFactory::MGnewOp(const ProblemDomain &a_indexSpace,
     newOp->m_alpha = m_alpha;
     newOp->m_beta = m_beta;
 
+    CreatedOp createdOp;
+    createdOp.op = newOp;
+    createdOp.ref = ref;
+    createdOp.depth = a_depth;
     if (a_depth == 0)
     {
         // don't need to coarsen anything for this
@@ -226,35 +246,15 @@ VariableCoeffPoissonOperatorFactory::MGnewOp(const ProblemDomain &a_indexSpace,
         RefCountedPtr<LevelData<FArrayBox>> bCoef(new LevelData<FArrayBox>);
         aCoef->define(layout, m_aCoef[ref]->nComp(), m_aCoef[ref]->ghostVect());
         bCoef->define(layout, m_bCoef[ref]->nComp(), m_bCoef[ref]->ghostVect());
-
-        // average coefficients to coarser level
-        // for now, do this with a CoarseAverage --
-        // may want to switch to harmonic averaging at some point
-        CoarseAverage averager_a(m_aCoef[ref]->getBoxes(), layout,
-                                 aCoef->nComp(), coarsening);
-
-        CoarseAverage averager_b(m_bCoef[ref]->getBoxes(), layout,
-                                 bCoef->nComp(), coarsening);
-
-        if (m_coefficient_average_type == CoarseAverage::arithmetic)
-        {
-            averager_a.averageToCoarse(*aCoef, *(m_aCoef[ref]));
-            averager_b.averageToCoarse(*bCoef, *(m_bCoef[ref]));
-        }
-        else if (m_coefficient_average_type == CoarseAverage::harmonic)
-        {
-            averager_a.averageToCoarseHarmonic(*aCoef, *(m_aCoef[ref]));
-            averager_b.averageToCoarseHarmonic(*bCoef, *(m_bCoef[ref]));
-        }
-        else
-        {
-            MayDay::Abort("VariableCoeffPoissonOperatorFactory::MGNewOp -- bad "
-                          "averagetype");
-        }
-
         newOp->m_aCoef = aCoef;
         newOp->m_bCoef = bCoef;
+
+        // the averager is kept to redo this when the coefficients change
+        createdOp.averager = RefCountedPtr<CoarseAverage>(new CoarseAverage(
+            m_aCoef[ref]->getBoxes(), layout, m_nComp, coarsening));
+        averageCoefficients(createdOp);
     }
+    m_createdOps.push_back(createdOp);
 
     newOp->computeLambda();
 
@@ -335,9 +335,70 @@ VariableCoeffPoissonOperatorFactory::AMRnewOp(const ProblemDomain &a_indexSpace)
 
     newOp->m_dxCrse = dxCrse;
 
+    CreatedOp createdOp;
+    createdOp.op = newOp;
+    createdOp.ref = ref;
+    createdOp.depth = 0;
+    m_createdOps.push_back(createdOp);
+
     return (AMRLevelOp<LevelData<FArrayBox>> *)newOp;
 }
 
+void VariableCoeffPoissonOperatorFactory::markBottom(int a_depth)
+{
+    for (int iop = 0; iop < m_createdOps.size(); iop++)
+    {
+        if (m_createdOps[iop].ref == 0 && m_createdOps[iop].depth == a_depth)
+        {
+            m_createdOps[iop].op->m_isBottom = true;
+        }
+    }
+}
+
+void VariableCoeffPoissonOperatorFactory::averageCoefficients(
+    const CreatedOp &a_createdOp)
+{
+    // average the coefficients of the AMR level onto the coarser layout
+    CoarseAverage &averager = *a_createdOp.averager;
+    VariableCoeffPoissonOperator &op = *a_createdOp.op;
+    if (m_coefficient_average_type == CoarseAverage::arithmetic)
+    {
+        averager.averageToCoarse(*op.m_aCoef, *(m_aCoef[a_createdOp.ref]));
+        averager.averageToCoarse(*op.m_bCoef, *(m_bCoef[a_createdOp.ref]));
+    }
+    else if (m_coefficient_average_type == CoarseAverage::harmonic)
+    {
+        averager.averageToCoarseHarmonic(*op.m_aCoef,
+                                         *(m_aCoef[a_createdOp.ref]));
+        averager.averageToCoarseHarmonic(*op.m_bCoef,
+                                         *(m_bCoef[a_createdOp.ref]));
+    }
+    else
+    {
+        MayDay::Abort("VariableCoeffPoissonOperatorFactory::"
+                      "averageCoefficients -- bad averagetype");
+    }
+}
+
+void VariableCoeffPoissonOperatorFactory::updateCoefficients()
+{
+    CH_TIME("VariableCoeffPoissonOperatorFactory::updateCoefficients");
+
+    for (int iop = 0; iop < m_createdOps.size(); iop++)
+    {
+        // the operators on the AMR levels share the coefficient data, so
+        // only the coarsened ones need updating
+        if (!m_createdOps[iop].averager.isNull())
+        {
+            averageCoefficients(m_createdOps[iop]);
+        }
+
+        // marks lambda (and with it the bottom factorisation and the single
+        // precision coefficients) as out of date
+        m_createdOps[iop].op->setAlphaAndBeta(m_alpha, m_beta);
+    }
+}
+
 int VariableCoeffPoissonOperatorFactory::refToFiner(
     const ProblemDomain &a_domain) const
 {
@@ -41,17 +41,27 @@ void RHSTagging<method_t, matter_t>::set_regrid_condition(
     const RealVect &a_dx, const std::array<double, SpaceDim> center,
     Real regrid_radius)
 {
-    DerivativeOperators derivs(a_dx);
     CH_assert(a_multigrid_vars.nComp() == NUM_MULTIGRID_VARS);
 
     method->initialise_method_vars(a_multigrid_vars, a_dx);
     matter->initialise_matter_vars(a_multigrid_vars, a_dx);
 
+    // the levels are still being built so there is no precomputed
+    // background yet, make one for this level
+    LevelData<FArrayBox> bh_vars(a_multigrid_vars.disjointBoxLayout(),
+                                 NUM_BH_VARS, a_multigrid_vars.ghostVect());
+    method->psi_and_Aij_functions->set_bowenyork_vars(bh_vars, a_dx, center);
+
     DataIterator dit = a_condition.dataIterator();
-    for (dit.begin(); dit.ok(); ++dit)
+    int nbox = dit.size();
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < nbox; ++ibox)
     {
-        FArrayBox &multigrid_vars_box = a_multigrid_vars[dit()];
-        FArrayBox &condition_box = a_condition[dit()];
+        DataIndex dind = dit[ibox];
+        FArrayBox &multigrid_vars_box = a_multigrid_vars[dind];
+        DerivativeOperators derivs(a_dx, multigrid_vars_box.box());
+        const FArrayBox &bh_vars_box = bh_vars[dind];
+        FArrayBox &condition_box = a_condition[dind];
         condition_box.setVal(0.0, 0);
 
         Box unghosted_box = condition_box.box();
@@ -65,8 +75,7 @@ void RHSTagging<method_t, matter_t>::set_regrid_condition(
 
             // Calculate the actual value of psi including BH part
             Real psi_reg = multigrid_vars_box(iv, c_psi_reg);
-            Real psi_bh =
-                method->psi_and_Aij_functions->compute_bowenyork_psi(loc);
+            Real psi_bh = bh_vars_box(iv, c_psi_bh);
             Real psi_0 = psi_reg + psi_bh;
             Real laplacian_psi_reg;
             derivs.scalar_Laplacian(laplacian_psi_reg, iv, multigrid_vars_box,
@@ -75,9 +84,9 @@ void RHSTagging<method_t, matter_t>::set_regrid_condition(
             // Get values of Aij
             Tensor<2, Real> Aij_reg;
             method->psi_and_Aij_functions->compute_ctt_Aij(
-                Aij_reg, multigrid_vars_box, iv, a_dx, loc);
+                Aij_reg, multigrid_vars_box, iv, derivs, loc);
             Tensor<2, Real> Aij_bh;
-            method->psi_and_Aij_functions->compute_bowenyork_Aij(Aij_bh, loc);
+            PsiAndAijFunctions::get_bowenyork_Aij(Aij_bh, bh_vars_box, iv);
             // This is \bar  A_ij \bar A^ij
             Real A2_0 = 0.0;
             FOR2(i, j)
@@ -87,8 +96,8 @@ void RHSTagging<method_t, matter_t>::set_regrid_condition(
             }
 
             // Compute emtensor components
-            const auto emtensor =
-                matter->compute_emtensor(iv, a_dx, multigrid_vars_box);
+            const auto emtensor = matter->compute_emtensor(
+                iv, derivs, multigrid_vars_box, bh_vars_box);
 
             if (regrid_radius > 0)
             {
@@ -0,0 +1,118 @@
+/* GRTresna
+ * Copyright 2024 The GRTL Collaboration.
+ * Please refer to LICENSE in GRTresna's root directory.
+ */
+
+#include "AsyncOutputWriter.hpp"
+#include "AMRIO.H"
+
+AsyncOutputWriter::AsyncOutputWriter(int a_max_pending)
+    : m_max_pending(a_max_pending), m_stop(false), m_writing(false)
+{
+    CH_assert(m_max_pending > 0);
+    m_thread = std::thread(&AsyncOutputWriter::run, this);
+}
+
+bool AsyncOutputWriter::is_available()
+{
+#ifdef CH_NTIMER
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AsyncOutputWriter::make_private_grids(
+    Vector<DisjointBoxLayout> &a_private,
+    const Vector<DisjointBoxLayout> &a_grids)
+{
+    // a new layout from the same boxes, rather than a copy of the handle
+    a_private.resize(a_grids.size());
+    for (int level = 0; level < a_grids.size(); level++)
+    {
+        a_private[level] =
+            DisjointBoxLayout(a_grids[level].boxArray(),
+                              a_grids[level].procIDs(),
+                              a_grids[level].physDomain());
+    }
+}
+
+AsyncOutputWriter::~AsyncOutputWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_queue_changed.notify_all();
+    m_thread.join();
+}
+
+void AsyncOutputWriter::wait_for_slot()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_queue_changed.wait(lock, [this] { return num_held() < m_max_pending; });
+}
+
+void AsyncOutputWriter::push(snapshot_t *a_snapshot)
+{
+    // the solver is the only thread that adds snapshots, so the slot found
+    // by wait_for_slot is still free here
+    std::unique_lock<std::mutex> lock(m_mutex);
+    CH_assert(num_held() < m_max_pending);
+    m_queue.push_back(a_snapshot);
+    m_queue_changed.notify_all();
+}
+
+void AsyncOutputWriter::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_queue_changed.wait(lock,
+                         [this] { return m_queue.empty() && !m_writing; });
+}
+
+void AsyncOutputWriter::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_queue_changed.wait(lock,
+                             [this] { return m_stop || !m_queue.empty(); });
+        // the remaining snapshots are still written when stopping
+        if (m_queue.empty())
+        {
+            return;
+        }
+
+        snapshot_t *snapshot = m_queue.front();
+        m_queue.pop_front();
+        m_writing = true;
+        m_queue_changed.notify_all();
+
+        lock.unlock();
+        write(snapshot);
+        lock.lock();
+
+        m_writing = false;
+        m_queue_changed.notify_all();
+    }
+}
+
+void AsyncOutputWriter::write(snapshot_t *a_snapshot)
+{
+#ifdef CH_USE_HDF5
+    WriteAMRHierarchyHDF5(a_snapshot->filename, a_snapshot->grids,
+                          a_snapshot->data, a_snapshot->variable_names,
+                          a_snapshot->domain_box, a_snapshot->dx,
+                          a_snapshot->dt, a_snapshot->time,
+                          a_snapshot->ref_ratio, a_snapshot->num_levels);
+#endif
+
+    // the data and its layouts are only referenced by the snapshot, so
+    // they can be released on this thread
+    for (int level = 0; level < a_snapshot->data.size(); level++)
+    {
+        delete a_snapshot->data[level];
+        a_snapshot->data[level] = NULL;
+    }
+    delete a_snapshot;
+}
@@ -0,0 +1,91 @@
+/* GRTresna
+ * Copyright 2024 The GRTL Collaboration.
+ * Please refer to LICENSE in GRTresna's root directory.
+ */
+
+#ifndef ASYNCOUTPUTWRITER_HPP_
+#define ASYNCOUTPUTWRITER_HPP_
+
+#include "Box.H"
+#include "DisjointBoxLayout.H"
+#include "FArrayBox.H"
+#include "LevelData.H"
+#include "REAL.H"
+#include "UsingNamespace.H"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/// Writes the NL_iteration snapshots from a background thread, so that the
+/// solver can continue with the next NL iteration. The snapshots are copies
+/// of the data, and at most max_pending of them (including the one being
+/// written) are held at a time, which bounds the extra memory: the copy for
+/// a new snapshot is only made once wait_for_slot returns. Chombo's HDF5
+/// writer uses collective operations on the global communicator, so this
+/// can only be used when running on a single rank, and the HDF5 library is
+/// not thread safe, so the owner must call wait before any HDF5 call of its
+/// own. The reference counts of Chombo's layouts are not atomic either, so
+/// a snapshot must be on layouts of its own (see make_private_grids), which
+/// the solver no longer touches once it is pushed, and its timers are not
+/// thread safe, so the writer is only available if they are compiled out
+/// (CH_NTIMER).
+class AsyncOutputWriter
+{
+  public:
+    struct snapshot_t
+    {
+        std::string filename;
+        Vector<DisjointBoxLayout> grids;     // not shared with the solver
+        Vector<LevelData<FArrayBox> *> data; // owned by the snapshot
+        Vector<std::string> variable_names;
+        Box domain_box;
+        Real dx;
+        Real dt;
+        Real time;
+        Vector<int> ref_ratio;
+        int num_levels;
+    };
+
+    AsyncOutputWriter(int a_max_pending);
+
+    /// whether the writer can be used in this build (no Chombo timers)
+    static bool is_available();
+
+    /// copies of a_grids that share nothing with them, to define the data
+    /// of a snapshot on
+    static void make_private_grids(Vector<DisjointBoxLayout> &a_private,
+                                   const Vector<DisjointBoxLayout> &a_grids);
+
+    /// waits for the pending snapshots to be written
+    ~AsyncOutputWriter();
+
+    /// blocks until another snapshot can be held
+    void wait_for_slot();
+
+    /// queues a snapshot for writing and takes ownership of it and its
+    /// data, call wait_for_slot before making the copy of the data
+    void push(snapshot_t *a_snapshot);
+
+    /// blocks until all the queued snapshots have been written
+    void wait();
+
+  private:
+    void run();
+
+    /// the number of snapshots held, with m_mutex locked
+    int num_held() const { return m_queue.size() + (m_writing ? 1 : 0); }
+
+    static void write(snapshot_t *a_snapshot);
+
+    int m_max_pending;
+    bool m_stop;
+    bool m_writing;
+    std::deque<snapshot_t *> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_queue_changed;
+    std::thread m_thread;
+};
+
+#endif /* ASYNCOUTPUTWRITER_HPP_ */
@@ -0,0 +1,202 @@
+/* GRTresna
+ * Copyright 2024 The GRTL Collaboration.
+ * Please refer to LICENSE in GRTresna's root directory.
+ */
+
+#include "CollectiveHDF5Writer.hpp"
+#include "SPMD.H"
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#ifdef CH_USE_HDF5
+
+void CollectiveHDF5Writer::write_data_attributes(
+    HDF5Handle &a_handle, const LevelData<FArrayBox> &a_data,
+    const IntVect &a_ghosts)
+{
+    HDF5HeaderData info;
+    info.m_intvect["ghost"] = a_data.ghostVect();
+    info.m_intvect["outputGhost"] = a_ghosts;
+    info.m_int["comps"] = a_data.nComp();
+    info.m_string["objectType"] = "FArrayBox";
+
+    std::string group = a_handle.getGroup();
+    a_handle.setGroup(group + "/data_attributes");
+    info.writeToFile(a_handle);
+    a_handle.setGroup(group);
+}
+
+void CollectiveHDF5Writer::write_levels(
+    const std::string &a_filename,
+    const Vector<LevelData<FArrayBox> *> &a_data, const IntVect &a_ghosts) const
+{
+    hid_t file_access = H5Pcreate(H5P_FILE_ACCESS);
+#ifdef CH_MPI
+    // the number of aggregators is a collective buffering hint to MPI-IO
+    MPI_Info info;
+    MPI_Info_create(&info);
+    if (m_params.num_aggregators > 0)
+    {
+        std::string num_nodes = std::to_string(m_params.num_aggregators);
+        MPI_Info_set(info, "cb_nodes", num_nodes.c_str());
+        MPI_Info_set(info, "romio_cb_write", "enable");
+    }
+    H5Pset_fapl_mpio(file_access, Chombo_MPI::comm, info);
+#endif
+    if (m_params.alignment > 0)
+    {
+        H5Pset_alignment(file_access, m_params.alignment, m_params.alignment);
+    }
+
+    hid_t file = H5Fopen(a_filename.c_str(), H5F_ACC_RDWR, file_access);
+    if (file < 0)
+    {
+        MayDay::Error("CollectiveHDF5Writer: could not open the output file");
+    }
+
+    for (int level = 0; level < a_data.size(); level++)
+    {
+        char level_str[20];
+        sprintf(level_str, "level_%d", level);
+        hid_t group = H5Gopen2(file, level_str, H5P_DEFAULT);
+        if (group < 0)
+        {
+            MayDay::Error("CollectiveHDF5Writer: missing level group");
+        }
+        write_level(group, *a_data[level], a_ghosts);
+        H5Gclose(group);
+    }
+
+    H5Fclose(file);
+    H5Pclose(file_access);
+#ifdef CH_MPI
+    MPI_Info_free(&info);
+#endif
+}
+
+void CollectiveHDF5Writer::write_level(hid_t a_group,
+                                       const LevelData<FArrayBox> &a_data,
+                                       const IntVect &a_ghosts) const
+{
+    const BoxLayout &layout = a_data.boxLayout();
+    const int num_comps = a_data.nComp();
+    const Interval comps(0, num_comps - 1);
+
+    // offsets of the boxes in the dataset, in the order of the layout as
+    // in Chombo, every rank knows the whole layout so no communication is
+    // needed
+    std::vector<long long> offsets(1, 0);
+    for (LayoutIterator lit = layout.layoutIterator(); lit.ok(); ++lit)
+    {
+        Box output_box = grow(layout[lit], a_ghosts);
+        offsets.push_back(offsets.back() + output_box.numPts() * num_comps);
+    }
+
+    // the local boxes in the order in which they appear in the file
+    std::vector<std::pair<int, DataIndex>> local_boxes;
+    for (DataIterator dit = a_data.dataIterator(); dit.ok(); ++dit)
+    {
+        local_boxes.push_back(std::make_pair(layout.index(dit()), dit()));
+    }
+    std::sort(local_boxes.begin(), local_boxes.end(),
+              [](const std::pair<int, DataIndex> &a,
+                 const std::pair<int, DataIndex> &b)
+              { return a.first < b.first; });
+
+    // select the local boxes in the file and pack them in one buffer
+    hsize_t total_size = offsets.back();
+    hid_t file_space = H5Screate_simple(1, &total_size, NULL);
+    H5Sselect_none(file_space);
+    const int num_local_boxes = local_boxes.size();
+    std::vector<long long> buffer_offsets(num_local_boxes + 1, 0);
+    for (int ibox = 0; ibox < num_local_boxes; ibox++)
+    {
+        const int index = local_boxes[ibox].first;
+        hsize_t start = offsets[index];
+        hsize_t count = offsets[index + 1] - offsets[index];
+        H5Sselect_hyperslab(file_space, H5S_SELECT_OR, &start, NULL, &count,
+                            NULL);
+        buffer_offsets[ibox + 1] = buffer_offsets[ibox] + count;
+    }
+
+    std::vector<Real> buffer(std::max(buffer_offsets.back(), 1LL));
+#pragma omp parallel for default(shared)
+    for (int ibox = 0; ibox < num_local_boxes; ibox++)
+    {
+        const DataIndex &dind = local_boxes[ibox].second;
+        Box output_box = grow(layout[dind], a_ghosts);
+        a_data[dind].linearOut(&buffer[buffer_offsets[ibox]], output_box,
+                               comps);
+    }
+
+    hsize_t local_size = buffer_offsets.back();
+    hid_t memory_space = H5Screate_simple(1, &local_size, NULL);
+    if (local_size == 0)
+    {
+        H5Sselect_none(memory_space);
+    }
+
+#ifdef CH_USE_DOUBLE
+    hid_t real_type = H5T_NATIVE_DOUBLE;
+#else
+    hid_t real_type = H5T_NATIVE_FLOAT;
+#endif
+
+    hid_t create_props = H5Pcreate(H5P_DATASET_CREATE);
+    H5Pset_fill_time(create_props, H5D_FILL_TIME_NEVER);
+    if (m_params.compression_level > 0 && total_size > 0)
+    {
+        hsize_t chunk_size =
+            std::min<hsize_t>(std::max(m_params.chunk_size, 1), total_size);
+        H5Pset_chunk(create_props, 1, &chunk_size);
+        H5Pset_shuffle(create_props);
+        H5Pset_deflate(create_props, m_params.compression_level);
+    }
+
+    hid_t transfer_props = H5Pcreate(H5P_DATASET_XFER);
+#ifdef CH_MPI
+    H5Pset_dxpl_mpio(transfer_props, H5FD_MPIO_COLLECTIVE);
+#endif
+
+    hid_t data_set = H5Dcreate2(a_group, "data:datatype=0", real_type,
+                                file_space, H5P_DEFAULT, create_props,
+                                H5P_DEFAULT);
+    herr_t status = H5Dwrite(data_set, real_type, memory_space, file_space,
+                             transfer_props, buffer.data());
+    if (data_set < 0 || status < 0)
+    {
+        MayDay::Error("CollectiveHDF5Writer: failed to write the data");
+    }
+    H5Dclose(data_set);
+
+    // the offsets are only written by rank 0, but the call is collective
+    hsize_t num_offsets = offsets.size();
+    hid_t offset_space = H5Screate_simple(1, &num_offsets, NULL);
+    hid_t offset_memory_space = H5Screate_simple(1, &num_offsets, NULL);
+    if (procID() != 0)
+    {
+        H5Sselect_none(offset_space);
+        H5Sselect_none(offset_memory_space);
+    }
+    hid_t offset_set =
+        H5Dcreate2(a_group, "data:offsets=0", H5T_NATIVE_LLONG, offset_space,
+                   H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    status = H5Dwrite(offset_set, H5T_NATIVE_LLONG, offset_memory_space,
+                      offset_space, transfer_props, offsets.data());
+    if (offset_set < 0 || status < 0)
+    {
+        MayDay::Error("CollectiveHDF5Writer: failed to write the offsets");
+    }
+    H5Dclose(offset_set);
+
+    H5Sclose(offset_memory_space);
+    H5Sclose(offset_space);
+    H5Pclose(transfer_props);
+    H5Pclose(create_props);
+    H5Sclose(memory_space);
+    H5Sclose(file_space);
+}
+
+#endif
@@ -0,0 +1,60 @@
+/* GRTresna
+ * Copyright 2024 The GRTL Collaboration.
+ * Please refer to LICENSE in GRTresna's root directory.
+ */
+
+#ifndef COLLECTIVEHDF5WRITER_HPP_
+#define COLLECTIVEHDF5WRITER_HPP_
+
+#include "CH_HDF5.H"
+#include "FArrayBox.H"
+#include "IntVect.H"
+#include "LevelData.H"
+#include "UsingNamespace.H"
+#include <string>
+
+/// Writes the "data" datasets of the levels of a Chombo AMR hierarchy file
+/// with a single collective MPI-IO write per level, optionally chunked and
+/// compressed (shuffle + deflate). The layout (offsets, box ordering and
+/// attributes) is the same as that of Chombo's write(handle, LevelData), so
+/// that GRChombo can read the file as usual, with the filters applied
+/// transparently by HDF5.
+/// The headers and boxes of the levels are written with Chombo first, then
+/// the file is closed and reopened here with the MPI-IO hints and alignment.
+class CollectiveHDF5Writer
+{
+  public:
+    struct params_t
+    {
+        int compression_level; // deflate level, 0 = no compression
+        int chunk_size;        // number of Reals in a chunk, if compressed
+        int num_aggregators;   // MPI-IO collective buffering nodes, 0 = auto
+        int alignment;         // alignment of the datasets in bytes, 0 = off
+    };
+
+    CollectiveHDF5Writer(const params_t &a_params) : m_params(a_params) {}
+
+#ifdef CH_USE_HDF5
+    /// Writes the data_attributes group of the current level, which
+    /// replaces the call to write(handle, data, "data", ghosts)
+    static void write_data_attributes(HDF5Handle &a_handle,
+                                      const LevelData<FArrayBox> &a_data,
+                                      const IntVect &a_ghosts);
+
+    /// Writes the data of every level (including a_ghosts ghost cells) to
+    /// a_filename, which must already contain the level groups
+    void write_levels(const std::string &a_filename,
+                      const Vector<LevelData<FArrayBox> *> &a_data,
+                      const IntVect &a_ghosts) const;
+#endif
+
+  private:
+    params_t m_params;
+
+#ifdef CH_USE_HDF5
+    void write_level(hid_t a_group, const LevelData<FArrayBox> &a_data,
+                     const IntVect &a_ghosts) const;
+#endif
+};
+
+#endif /* COLLECTIVEHDF5WRITER_HPP_ */
@@ -0,0 +1,33 @@
+/* GRTresna
+ * Copyright 2024 The GRTL Collaboration.
+ * Please refer to LICENSE in GRTresna's root directory.
+ */
+
+#ifndef BHVARIABLES_HPP
+#define BHVARIABLES_HPP
+
+#include "ArrayTools.hpp"
+
+// assign an enum to each of the Bowen York background variables
+enum
+{
+    c_psi_bh,
+
+    c_A11_bh,
+    c_A12_bh,
+    c_A13_bh,
+    c_A22_bh,
+    c_A23_bh,
+    c_A33_bh,
+
+    NUM_BH_VARS
+};
+
+namespace BHVariables
+{
+static const std::array<std::string, NUM_BH_VARS> variable_names = {
+    "psi_bh", "A11_bh", "A12_bh", "A13_bh", "A22_bh", "A23_bh", "A33_bh"};
+
+} // namespace BHVariables
+
+#endif /* BHVARIABLES_HPP */
@@ -60,6 +60,7 @@ int main(int argc, char *argv[])
             params.grid_params.center);
 
     Vector<LevelData<FArrayBox> *> multigrid_vars(numLevels, NULL);
+    Vector<LevelData<FArrayBox> *> bh_vars(numLevels, NULL);
     Vector<LevelData<FArrayBox> *> constraint_vars(numLevels, NULL);
     Vector<LevelData<FArrayBox> *> rhs(numLevels, NULL);
     Vector<LevelData<FArrayBox> *> diagnostic_vars(numLevels, NULL);
@@ -75,6 +76,8 @@ int main(int argc, char *argv[])
     {
         multigrid_vars[ilev] = new LevelData<FArrayBox>(
             grids->grids_data[ilev], NUM_MULTIGRID_VARS, ghosts);
+        bh_vars[ilev] = new LevelData<FArrayBox>(grids->grids_data[ilev],
+                                                 NUM_BH_VARS, ghosts);
 
         constraint_vars[ilev] = new LevelData<FArrayBox>(
             grids->grids_data[ilev], NUM_CONSTRAINT_VARS, ghosts);
@@ -95,6 +98,8 @@ int main(int argc, char *argv[])
         RealVect dxLevel = grids->vectDx[ilev];
 
         method->initialise_method_vars(*multigrid_vars[ilev], dxLevel);
+        psi_and_Aij_functions->set_bowenyork_vars(
+            *bh_vars[ilev], dxLevel, params.grid_params.center);
         matter->initialise_matter_vars(*multigrid_vars[ilev], dxLevel);
 
         method->initialise_constraint_vars(*constraint_vars[ilev], dxLevel);
@@ -136,8 +141,8 @@ int main(int argc, char *argv[])
         for (int ilev = 0; ilev < numLevels; ilev++)
         {
             RealVect dxLevel = grids->vectDx[ilev];
-            method->solve_analytic(multigrid_vars[ilev], rhs[ilev],
-                                   grids->vectDx[ilev]);
+            method->solve_analytic(multigrid_vars[ilev], bh_vars[ilev],
+                                   rhs[ilev], grids->vectDx[ilev]);
         }
         filling_solver_vars = false;
         grids->fill_ghosts_correct_coarse(multigrid_vars, filling_solver_vars);
@@ -145,17 +150,17 @@ int main(int argc, char *argv[])
         for (int ilev = 0; ilev < numLevels; ilev++)
         {
             RealVect dxLevel = grids->vectDx[ilev];
-            method->set_elliptic_terms(multigrid_vars[ilev], rhs[ilev],
-                                       aCoef[ilev], bCoef[ilev],
+            method->set_elliptic_terms(multigrid_vars[ilev], bh_vars[ilev],
+                                       rhs[ilev], aCoef[ilev], bCoef[ilev],
                                        grids->vectDx[ilev]);
         }
 
         for (int ilev = 0; ilev < numLevels; ilev++)
         {
             RealVect dxLevel = grids->vectDx[ilev];
-            diagnostics->compute_constraint_terms(multigrid_vars[ilev],
-                                                  diagnostic_vars[ilev],
-                                                  rhs[ilev], dxLevel);
+            diagnostics->compute_constraint_terms(
+                multigrid_vars[ilev], bh_vars[ilev], diagnostic_vars[ilev],
+                rhs[ilev], dxLevel);
         }
 
         for (int ilev = 0; ilev < numLevels; ilev++)
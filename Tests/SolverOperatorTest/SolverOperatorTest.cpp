@@ -0,0 +1,571 @@
+/* GRTresna
+ * Copyright 2024 The GRTL Collaboration.
+ * Please refer to LICENSE in GRTresna's root directory.
+ */
+
+#ifdef CH_MPI
+#include "mpi.h"
+#endif
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BRMeshRefine.H"
+#include "BoxIterator.H"
+#include "ConstraintVariables.hpp"
+#include "FFTPoissonSolver.hpp"
+#include "GRParmParse.hpp"
+#include "Grids.hpp"
+#include "LoadBalance.H"
+#include "SetBCs.H"
+#include "VariableCoeffPoissonOperatorFactory.H"
+
+using namespace std;
+
+// Tests of the options of the linear solver steps on a single operator of
+// the multigrid hierarchy, rather than through a full solve. The tests to
+// run can be named after the input file, otherwise they all run.
+
+// The signs used by the solver, so that the operator is
+// aCoef + bCoef * Laplacian
+const Real alpha = 1.;
+const Real beta = -1.;
+
+// A single level of the grids in params.txt, with smoothly varying
+// coefficients for which the operator is negative definite, and the
+// operator factory of the solver for it
+class OperatorSetup
+{
+  public:
+    // if a_vary_only_psi the other components have constant coefficients
+    OperatorSetup(const Grids::params_t &a_grid_params,
+                  bool a_vary_only_psi = false)
+        : grids(a_grid_params, NULL, false)
+    {
+        grids.set_grids();
+        const DisjointBoxLayout &layout = grids.grids_data[0];
+        aCoef.push_back(RefCountedPtr<LevelData<FArrayBox>>(
+            new LevelData<FArrayBox>(layout, NUM_CONSTRAINT_VARS)));
+        bCoef.push_back(RefCountedPtr<LevelData<FArrayBox>>(
+            new LevelData<FArrayBox>(layout, NUM_CONSTRAINT_VARS)));
+
+        const Real dx = a_grid_params.coarsestDx;
+        const Real wavenumber = 2. * M_PI / a_grid_params.domainLength[0];
+        for (DataIterator dit = layout.dataIterator(); dit.ok(); ++dit)
+        {
+            for (BoxIterator bit(layout[dit]); bit.ok(); ++bit)
+            {
+                const IntVect iv = bit();
+                RealVect phase;
+                for (int idir = 0; idir < SpaceDim; idir++)
+                {
+                    phase[idir] = wavenumber * (iv[idir] + 0.5) * dx;
+                }
+                for (int comp = 0; comp < NUM_CONSTRAINT_VARS; comp++)
+                {
+                    Real a = -1.;
+                    Real b = 1.;
+                    if (comp == c_psi || !a_vary_only_psi)
+                    {
+                        a = -1. - 0.5 * sin(phase[0]) * cos(phase[1]);
+                        b = 1. + 0.25 * cos(phase[2]);
+                    }
+                    (*aCoef[0])[dit](iv, comp) = a;
+                    (*bCoef[0])[dit](iv, comp) = b;
+                }
+            }
+        }
+
+        factory = RefCountedPtr<AMRLevelOpFactory<LevelData<FArrayBox>>>(
+            defineOperatorFactory(grids.grids_data, grids.vectDomain, aCoef,
+                                  bCoef, a_grid_params, alpha, beta));
+    }
+
+    // A new operator for the level coarsened a_depth times by multigrid, or
+    // NULL if multigrid stops before. The operator prepares for the
+    // smoother options when it is made, so they must be set before.
+    VariableCoeffPoissonOperator *new_op(int a_depth = 0)
+    {
+        return (VariableCoeffPoissonOperator *)factory->MGnewOp(
+            grids.vectDomain[0], a_depth, true);
+    }
+
+    Grids grids;
+    Vector<RefCountedPtr<LevelData<FArrayBox>>> aCoef;
+    Vector<RefCountedPtr<LevelData<FArrayBox>>> bCoef;
+    RefCountedPtr<AMRLevelOpFactory<LevelData<FArrayBox>>> factory;
+};
+
+// A deterministic value in [-1, 1] for each cell and component, which does
+// not depend on the boxes and has all the frequencies of the grid in it
+Real noise(const IntVect &a_iv, int a_comp, unsigned int a_seed)
+{
+    unsigned int hash = a_seed + 7919u * a_comp;
+    for (int idir = 0; idir < SpaceDim; idir++)
+    {
+        hash = (hash ^ (unsigned int)a_iv[idir]) * 2654435761u;
+        hash ^= hash >> 15;
+    }
+    return (hash % 20001u) / 10000. - 1.;
+}
+
+// Fills the valid cells of a_data with noise, and the ghosts with zeros
+void set_noise(LevelData<FArrayBox> &a_data, unsigned int a_seed)
+{
+    const DisjointBoxLayout &layout = a_data.disjointBoxLayout();
+    for (DataIterator dit = layout.dataIterator(); dit.ok(); ++dit)
+    {
+        a_data[dit].setVal(0.);
+        for (BoxIterator bit(layout[dit]); bit.ok(); ++bit)
+        {
+            for (int comp = 0; comp < a_data.nComp(); comp++)
+            {
+                a_data[dit](bit(), comp) = noise(bit(), comp, a_seed);
+            }
+        }
+    }
+}
+
+// Largest absolute value of the components a_comps over the valid cells
+Real max_norm(const LevelData<FArrayBox> &a_data, const Interval &a_comps)
+{
+    const DisjointBoxLayout &layout = a_data.disjointBoxLayout();
+    Real max_value = 0.;
+    for (DataIterator dit = layout.dataIterator(); dit.ok(); ++dit)
+    {
+        max_value = max(max_value, a_data[dit].norm(layout[dit], 0,
+                                                    a_comps.begin(),
+                                                    a_comps.size()));
+    }
+#ifdef CH_MPI
+    Real local_max = max_value;
+    MPI_Allreduce(&local_max, &max_value, 1, MPI_CH_REAL, MPI_MAX,
+                  Chombo_MPI::comm);
+#endif
+    return max_value;
+}
+
+Real max_norm(const LevelData<FArrayBox> &a_data)
+{
+    return max_norm(a_data, a_data.interval());
+}
+
+// Largest difference between two sets of data on the same layout, relative
+// to the largest value of a_expected
+Real relative_difference(const LevelData<FArrayBox> &a_data,
+                         const LevelData<FArrayBox> &a_expected)
+{
+    const DisjointBoxLayout &layout = a_data.disjointBoxLayout();
+    LevelData<FArrayBox> difference(layout, a_data.nComp());
+    for (DataIterator dit = layout.dataIterator(); dit.ok(); ++dit)
+    {
+        difference[dit].copy(a_data[dit]);
+        difference[dit].minus(a_expected[dit], 0, 0, a_data.nComp());
+    }
+    return max_norm(difference) / max_norm(a_expected);
+}
+
+// Relaxes the same noise with a new operator of the level, made with the
+// current smoother options
+void relax_noise(LevelData<FArrayBox> &a_phi, OperatorSetup &a_setup,
+                 int a_iterations)
+{
+    VariableCoeffPoissonOperator *op = a_setup.new_op();
+    const DisjointBoxLayout &layout = op->m_aCoef->disjointBoxLayout();
+    a_phi.define(layout, NUM_CONSTRAINT_VARS, IntVect::Unit);
+    LevelData<FArrayBox> rhs(layout, NUM_CONSTRAINT_VARS);
+    set_noise(a_phi, 1);
+    set_noise(rhs, 2);
+    op->relax(a_phi, rhs, a_iterations);
+    delete op;
+}
+
+// The factor by which a_iterations steps of the current smoother reduce
+// the largest residual of noise, on a new operator of the level
+Real residual_reduction(OperatorSetup &a_setup, int a_iterations)
+{
+    VariableCoeffPoissonOperator *op = a_setup.new_op();
+    const DisjointBoxLayout &layout = op->m_aCoef->disjointBoxLayout();
+    LevelData<FArrayBox> phi(layout, NUM_CONSTRAINT_VARS, IntVect::Unit);
+    LevelData<FArrayBox> rhs(layout, NUM_CONSTRAINT_VARS);
+    LevelData<FArrayBox> residual(layout, NUM_CONSTRAINT_VARS);
+    set_noise(phi, 1);
+    set_noise(rhs, 2);
+    op->residual(residual, phi, rhs, true);
+    const Real initial_residual = max_norm(residual);
+    op->relax(phi, rhs, a_iterations);
+    op->residual(residual, phi, rhs, true);
+    delete op;
+    return max_norm(residual) / initial_residual;
+}
+
+// Fails, saying by how much, unless a_value is below a_limit
+int check_below(const std::string &a_name, Real a_value, Real a_limit)
+{
+    // written this way round so that a NaN fails
+    if (!(a_value < a_limit))
+    {
+        pout() << a_name << " is " << a_value << ", which is not below "
+               << a_limit << endl;
+        return -1;
+    }
+    return 0;
+}
+
+// Overlapping the exchanges with the interior (relax mode 2) only changes
+// the order in which the cells of one colour are smoothed, which does not
+// change the result of GSRB
+int test_overlap_gsrb(const Grids::params_t &a_grid_params)
+{
+    OperatorSetup setup(a_grid_params);
+    LevelData<FArrayBox> level_phi, overlap_phi;
+    AMRPoissonOp::s_relaxMode = 1;
+    relax_noise(level_phi, setup, 4);
+    AMRPoissonOp::s_relaxMode = 2;
+    relax_noise(overlap_phi, setup, 4);
+    return check_below("overlapGSRB difference",
+                       relative_difference(overlap_phi, level_phi), 1e-12);
+}
+
+// The C++ GSRB kernel, which smooths all the components a row at a time,
+// should agree with the Fortran one up to rounding
+int test_interleaved_gsrb(const Grids::params_t &a_grid_params)
+{
+    OperatorSetup setup(a_grid_params);
+    LevelData<FArrayBox> fortran_phi, interleaved_phi;
+    VariableCoeffPoissonOperator::s_interleavedGSRB = false;
+    relax_noise(fortran_phi, setup, 4);
+    VariableCoeffPoissonOperator::s_interleavedGSRB = true;
+    relax_noise(interleaved_phi, setup, 4);
+    return check_below("interleaved GSRB difference",
+                       relative_difference(interleaved_phi, fortran_phi),
+                       1e-10);
+}
+
+// A few steps of the Chebyshev smoother, with the Gershgorin bound on the
+// spectrum of lambda * L, should damp the residual of noise, which is
+// dominated by the high frequencies
+int test_chebyshev_smoother(const Grids::params_t &a_grid_params)
+{
+    OperatorSetup setup(a_grid_params);
+    VariableCoeffPoissonOperator::s_chebyshevSmoother = true;
+    return check_below("Chebyshev residual reduction",
+                       residual_reduction(setup, 4), 0.5);
+}
+
+// GSRB with the coefficients and lambda in single precision should only
+// differ from the same kernel in double precision by the rounding of the
+// coefficients
+int test_single_precision_gsrb(const Grids::params_t &a_grid_params)
+{
+    OperatorSetup setup(a_grid_params);
+    LevelData<FArrayBox> double_phi, single_phi;
+    VariableCoeffPoissonOperator::s_interleavedGSRB = true;
+    relax_noise(double_phi, setup, 4);
+    VariableCoeffPoissonOperator::s_singlePrecisionSmoother = true;
+    relax_noise(single_phi, setup, 4);
+    return check_below("single precision GSRB difference",
+                       relative_difference(single_phi, double_phi), 1e-5);
+}
+
+// Only the coarsest operator multigrid makes should be flagged as the
+// bottom, where the preconditioner should then solve exactly with the LU
+// factors of the whole level
+int test_direct_bottom_solve(const Grids::params_t &a_grid_params)
+{
+    OperatorSetup setup(a_grid_params);
+    VariableCoeffPoissonOperator::s_directBottomSolve = true;
+
+    // asking for the first operator that cannot be made flags the bottom
+    std::vector<VariableCoeffPoissonOperator *> ops;
+    VariableCoeffPoissonOperator *next_op = setup.new_op(0);
+    while (next_op != NULL)
+    {
+        ops.push_back(next_op);
+        next_op = setup.new_op(ops.size());
+    }
+    int failed = 0;
+    for (int depth = 0; depth < ops.size(); depth++)
+    {
+        const bool is_bottom = (depth == ops.size() - 1);
+        if (ops[depth]->m_isBottom != is_bottom)
+        {
+            pout() << "The operator at depth " << depth << " of "
+                   << ops.size() << (is_bottom ? " is not" : " is")
+                   << " flagged as the bottom" << endl;
+            failed = -1;
+        }
+    }
+
+    VariableCoeffPoissonOperator *bottom_op = ops.back();
+    const DisjointBoxLayout &layout = bottom_op->m_aCoef->disjointBoxLayout();
+    LevelData<FArrayBox> correction(layout, NUM_CONSTRAINT_VARS,
+                                    IntVect::Unit);
+    LevelData<FArrayBox> rhs(layout, NUM_CONSTRAINT_VARS);
+    LevelData<FArrayBox> residual(layout, NUM_CONSTRAINT_VARS);
+    set_noise(rhs, 2);
+    bottom_op->preCond(correction, rhs);
+    bottom_op->residual(residual, correction, rhs, true);
+    failed |= check_below("direct bottom solve residual",
+                          max_norm(residual) / max_norm(rhs), 1e-10);
+
+    for (VariableCoeffPoissonOperator *op : ops)
+    {
+        delete op;
+    }
+    return failed;
+}
+
+// The FFT solver should report the components with constant coefficients
+// as exact, and leave no residual in them with the operator of the level
+int test_fft_solver(const Grids::params_t &a_grid_params)
+{
+    const bool vary_only_psi = true;
+    OperatorSetup setup(a_grid_params, vary_only_psi);
+    VariableCoeffPoissonOperator *op = setup.new_op();
+    const DisjointBoxLayout &layout = setup.grids.grids_data[0];
+    LevelData<FArrayBox> soln(layout, NUM_CONSTRAINT_VARS, IntVect::Unit);
+    LevelData<FArrayBox> rhs(layout, NUM_CONSTRAINT_VARS);
+    LevelData<FArrayBox> residual(layout, NUM_CONSTRAINT_VARS);
+    set_noise(rhs, 2);
+
+    FFTPoissonSolver fft_solver(layout, setup.grids.vectDomain[0],
+                                a_grid_params.coarsestDx);
+    std::vector<bool> exact = fft_solver.solve(
+        soln, rhs, *setup.aCoef[0], *setup.bCoef[0], alpha, beta);
+    op->residual(residual, soln, rhs, true);
+    delete op;
+
+    int failed = 0;
+    for (int comp = 0; comp < NUM_CONSTRAINT_VARS; comp++)
+    {
+        const std::string &name = ConstraintVariables::variable_names[comp];
+        const bool should_be_exact = (comp != c_psi);
+        if (exact[comp] != should_be_exact)
+        {
+            pout() << "The FFT solution of " << name
+                   << (should_be_exact ? " is not" : " is")
+                   << " reported as exact" << endl;
+            failed = -1;
+        }
+        if (should_be_exact)
+        {
+            const Interval comps(comp, comp);
+            failed |= check_below("FFT residual of " + name,
+                                  max_norm(residual, comps) /
+                                      max_norm(rhs, comps),
+                                  1e-10);
+        }
+    }
+    return failed;
+}
+
+// The boundary cells that ParseBC fills from the plans of GlobalBCRS (for a
+// planned and an unplanned ghost width, and on a coarsened multigrid level)
+// should match those filled from a plan made directly, with non periodic
+// boundaries so that there is something to fill
+int test_boundary_plans(const Grids::params_t &a_grid_params)
+{
+    const BoundaryConditions::params_t saved_params =
+        GlobalBCRS::s_boundary_params;
+    const bool saved_parsed = GlobalBCRS::s_areBCsParsed;
+
+    BoundaryConditions::params_t boundary_params =
+        a_grid_params.boundary_params;
+    std::array<bool, CH_SPACEDIM> is_periodic;
+    is_periodic.fill(false);
+    boundary_params.set_is_periodic(is_periodic);
+    boundary_params.set_hi_boundary(boundary_params.hi_boundary);
+    boundary_params.set_lo_boundary(boundary_params.lo_boundary);
+    GlobalBCRS::s_boundary_params = boundary_params;
+    GlobalBCRS::s_areBCsParsed = true;
+
+    const ProblemDomain domain(a_grid_params.coarsestDomain.domainBox());
+    const Real dx = a_grid_params.coarsestDx;
+    Vector<Box> boxes;
+    domainSplit(domain.domainBox(), boxes, 8, 4);
+    Vector<int> procs;
+    LoadBalance(procs, boxes);
+    const DisjointBoxLayout grids(boxes, procs, domain);
+    GlobalBCRS::define_plans(Vector<DisjointBoxLayout>(1, grids),
+                             Vector<ProblemDomain>(1, domain),
+                             Vector<Real>(1, dx), std::vector<int>(1, 1));
+
+    Real max_difference = 0.;
+    for (int coarsening = 1; coarsening <= 2; coarsening *= 2)
+    {
+        ProblemDomain level_domain = domain;
+        level_domain.coarsen(coarsening);
+        const Real level_dx = dx * coarsening;
+        DisjointBoxLayout layout;
+        coarsen_dbl(layout, grids, coarsening);
+        BoundaryConditions boundaries;
+        boundaries.define(level_dx, boundary_params, level_domain, 1);
+
+        for (DataIterator dit = layout.dataIterator(); dit.ok(); ++dit)
+        {
+            for (int ghosts = 1; ghosts <= 2; ghosts++)
+            {
+                const Box &box = layout[dit];
+                FArrayBox state(grow(box, ghosts), NUM_CONSTRAINT_VARS);
+                state.setVal(0.);
+                for (BoxIterator bit(box); bit.ok(); ++bit)
+                {
+                    for (int icomp = 0; icomp < NUM_CONSTRAINT_VARS; icomp++)
+                    {
+                        state(bit(), icomp) = bit().sum() + icomp;
+                    }
+                }
+                FArrayBox expected(state.box(), NUM_CONSTRAINT_VARS);
+                expected.copy(state);
+
+                ParseBC(state, box, level_domain, level_dx, false);
+                BoundaryConditions::fill_plan_t plan;
+                boundaries.get_constraint_fill_plan(plan, expected.box());
+                boundaries.fill_constraint_box(expected, plan);
+
+                state.minus(expected);
+                max_difference = max(max_difference,
+                                     state.norm(0, 0, NUM_CONSTRAINT_VARS));
+            }
+        }
+    }
+#ifdef CH_MPI
+    Real local_difference = max_difference;
+    MPI_Allreduce(&local_difference, &max_difference, 1, MPI_CH_REAL, MPI_MAX,
+                  Chombo_MPI::comm);
+#endif
+
+    GlobalBCRS::s_boundary_params = saved_params;
+    GlobalBCRS::s_areBCsParsed = saved_parsed;
+    return check_below("boundary plans difference", max_difference, 1e-12);
+}
+
+// The batched reductions of Grids should agree with the separate sums and
+// norms over the level, and give the same result every time
+int test_reductions(const Grids::params_t &a_grid_params)
+{
+    OperatorSetup setup(a_grid_params);
+    Grids &grids = setup.grids;
+    LevelData<FArrayBox> data(grids.grids_data[0], 2);
+    set_noise(data, 3);
+    Vector<LevelData<FArrayBox> *> vars(1, &data);
+    const Interval comp0(0, 0);
+    const Interval comp1(1, 1);
+    std::vector<Grids::reduction_t> reductions = {
+        {vars, comp0, false}, {vars, comp0, true}, {vars, comp1, true}};
+    const Real expected[3] = {grids.compute_sum(vars, comp0),
+                              grids.compute_norm(vars, comp0),
+                              grids.compute_norm(vars, comp1)};
+
+    std::vector<Real> results, repeated_results;
+    grids.compute_reductions(results, reductions);
+    grids.compute_reductions(repeated_results, reductions);
+
+    int failed = 0;
+    for (int ired = 0; ired < reductions.size(); ired++)
+    {
+        const std::string name = "reduction " + std::to_string(ired);
+        failed |= check_below(name + " error",
+                              abs(results[ired] - expected[ired]),
+                              1e-10 * max(abs(expected[ired]), 1.));
+        if (repeated_results[ired] != results[ired])
+        {
+            pout() << name << " changed from " << results[ired] << " to "
+                   << repeated_results[ired] << " when repeated" << endl;
+            failed = -1;
+        }
+    }
+    return failed;
+}
+
+// The smoother options are global, so they are put back to the defaults
+// of the solver before each test
+void reset_solver_options()
+{
+    AMRPoissonOp::s_relaxMode = 1;
+    VariableCoeffPoissonOperator::s_interleavedGSRB = false;
+    VariableCoeffPoissonOperator::s_chebyshevSmoother = false;
+    VariableCoeffPoissonOperator::s_singlePrecisionSmoother = false;
+    VariableCoeffPoissonOperator::s_directBottomSolve = false;
+    VariableCoeffPoissonOperator::s_maxDirectBottomCells = 1024;
+}
+
+typedef int (*test_t)(const Grids::params_t &a_grid_params);
+
+int main(int argc, char *argv[])
+{
+    int failed = 0;
+
+#ifdef CH_MPI
+    MPI_Init(&argc, &argv);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank == 0)
+        cout << "Running with MPI" << endl;
+#endif
+
+    if (argc < 2)
+    {
+        cerr << " usage " << argv[0] << " <input_file_name> [test names]"
+             << endl;
+        exit(0);
+    }
+
+    GRParmParse pp(0, argv + argc, NULL, argv[1]);
+    Grids::params_t grid_params;
+    Grids::read_params(pp, grid_params);
+
+    const std::vector<std::pair<std::string, test_t>> tests = {
+        {"overlap_gsrb", test_overlap_gsrb},
+        {"interleaved_gsrb", test_interleaved_gsrb},
+        {"chebyshev_smoother", test_chebyshev_smoother},
+        {"single_precision_gsrb", test_single_precision_gsrb},
+        {"direct_bottom_solve", test_direct_bottom_solve},
+        {"fft_solver", test_fft_solver},
+        {"boundary_plans", test_boundary_plans},
+        {"reductions", test_reductions}};
+
+    // any arguments after the input file are the names of the tests to run
+    std::vector<std::string> names(argv + 2, argv + argc);
+    if (names.empty())
+    {
+        for (const auto &test : tests)
+        {
+            names.push_back(test.first);
+        }
+    }
+
+    for (const std::string &name : names)
+    {
+        auto test = tests.begin();
+        while (test != tests.end() && test->first != name)
+        {
+            ++test;
+        }
+        if (test == tests.end())
+        {
+            pout() << "There is no test called " << name << endl;
+            failed = -1;
+            continue;
+        }
+        reset_solver_options();
+        int test_failed = test->second(grid_params);
+        pout() << name << (test_failed ? " failed" : " passed") << endl;
+        failed |= test_failed;
+    }
+
+    if (failed == 0)
+        std::cout << "SolverOperator test passed..." << std::endl;
+    else
+        std::cout << "SolverOperator test failed..." << std::endl;
+
+#ifdef CH_MPI
+    MPI_Finalize();
+#endif
+
+    return failed;
+}
@@ -0,0 +1,295 @@
+/* GRTresna
+ * Copyright 2024 The GRTL Collaboration.
+ * Please refer to LICENSE in GRTresna's root directory.
+ */
+
+#ifdef CH_MPI
+#include "mpi.h"
+#endif
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CTTK.hpp"
+#include "GRParmParse.hpp"
+#include "GRSolver.hpp"
+#include "SPMD.H"
+#include "ScalarField.hpp"
+#include "SimulationParameters.hpp"
+
+using namespace std;
+
+// Small solves with the options of the non linear iterations, each checked
+// against a run with the options in params.txt. The tests to run can be
+// named after the input file, otherwise they all run.
+
+typedef CTTK<ScalarField> method_t;
+typedef SimulationParameters<method_t, ScalarField> params_t;
+typedef GRSolver<method_t, ScalarField> solver_t;
+
+// Runs the full solver with the given parameters, and returns it so that
+// its solution can be compared with that of other runs
+solver_t *run_solver(GRParmParse &pp, const params_t &a_params)
+{
+    solver_t *solver = new solver_t(pp, a_params);
+    solver->setup();
+    solver->run();
+    return solver;
+}
+
+// The run with the options in params.txt, made once for all the tests that
+// compare with it
+const solver_t &reference_run(GRParmParse &pp, const params_t &a_params)
+{
+    static const solver_t *reference = run_solver(pp, a_params);
+    return *reference;
+}
+
+// Largest difference in psi_reg between two runs on the same grids
+Real psi_difference(const solver_t &a_solver1, const solver_t &a_solver2)
+{
+    const Vector<LevelData<FArrayBox> *> &vars1 =
+        a_solver1.get_multigrid_vars();
+    const Vector<LevelData<FArrayBox> *> &vars2 =
+        a_solver2.get_multigrid_vars();
+    const Interval psi_comp(c_psi_reg, c_psi_reg);
+
+    Real max_difference = 0.;
+    for (int ilev = 0; ilev < vars1.size(); ilev++)
+    {
+        const DisjointBoxLayout &grids = vars1[ilev]->disjointBoxLayout();
+        LevelData<FArrayBox> psi2(grids, 1);
+        vars2[ilev]->copyTo(psi_comp, psi2, Interval(0, 0));
+        for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+        {
+            FArrayBox difference(grids[dit], 1);
+            difference.copy((*vars1[ilev])[dit], c_psi_reg, 0, 1);
+            difference.minus(psi2[dit], 0, 0, 1);
+            max_difference = max(max_difference, difference.norm(0, 0, 1));
+        }
+    }
+#ifdef CH_MPI
+    Real local_difference = max_difference;
+    MPI_Allreduce(&local_difference, &max_difference, 1, MPI_CH_REAL, MPI_MAX,
+                  Chombo_MPI::comm);
+#endif
+    return max_difference;
+}
+
+// Fails, saying by how much, unless a_value is below a_limit
+int check_below(const std::string &a_name, Real a_value, Real a_limit)
+{
+    // written this way round so that a NaN fails
+    if (!(a_value < a_limit))
+    {
+        pout() << a_name << " is " << a_value << ", which is not below "
+               << a_limit << endl;
+        return -1;
+    }
+    return 0;
+}
+
+// For the options that change the iterations, and so the solution slightly,
+// the run should converge at least as well as the reference
+int check_converged_as_reference(const std::string &a_name,
+                                 const solver_t &a_solver,
+                                 const solver_t &a_reference)
+{
+    int failed = check_below(a_name + " Ham error", a_solver.get_Ham_error(),
+                             1.1 * a_reference.get_Ham_error() + 1e-8);
+    failed |= check_below(a_name + " Mom error", a_solver.get_Mom_error(),
+                          1.1 * a_reference.get_Mom_error() + 1e-8);
+    failed |= check_below(a_name + " psi difference",
+                          psi_difference(a_solver, a_reference), 1e-5);
+    return failed;
+}
+
+// Anderson mixing of the iterates should converge at least as well as the
+// plain iterations
+int test_anderson_mixing(GRParmParse &pp, const params_t &a_params)
+{
+    params_t params = a_params;
+    params.base_params.use_anderson_mixing = true;
+    params.base_params.anderson_depth = 3;
+    solver_t *solver = run_solver(pp, params);
+    int failed = check_converged_as_reference(
+        "anderson_mixing", *solver, reference_run(pp, a_params));
+    delete solver;
+    return failed;
+}
+
+// Deflating the zero modes, with the means removed in batches, instead of
+// the small aCoef of deactivate_zero_mode changes the solution slightly
+int test_deflate_zero_mode(GRParmParse &pp, const params_t &a_params)
+{
+    params_t params = a_params;
+    params.method_params.deflate_zero_mode = true;
+    solver_t *solver = run_solver(pp, params);
+    int failed = check_converged_as_reference(
+        "deflate_zero_mode", *solver, reference_run(pp, a_params));
+    delete solver;
+    return failed;
+}
+
+// Checking the errors less often can only delay the end of the non linear
+// iterations, and the final errors are still those of the final solution
+int test_error_check_interval(GRParmParse &pp, const params_t &a_params)
+{
+    params_t params = a_params;
+    params.base_params.error_check_interval = 3;
+    solver_t *solver = run_solver(pp, params);
+    int failed = check_converged_as_reference(
+        "error_check_interval", *solver, reference_run(pp, a_params));
+    delete solver;
+    return failed;
+}
+
+#ifdef CH_USE_HDF5
+// Writing the diagnostic files in the background, at every step and with a
+// queue of one so that the solver has to wait for the writer, should not
+// change the solution
+int test_async_output(GRParmParse &pp, const params_t &a_params)
+{
+    params_t params = a_params;
+    params.base_params.write_diagnostics = true;
+    params.base_params.diagnostic_interval = 1;
+    params.base_params.async_output = true;
+    params.base_params.async_output_queue = 1;
+    solver_t *solver = run_solver(pp, params);
+    const solver_t &reference = reference_run(pp, a_params);
+    int failed = check_below("async_output psi difference",
+                             psi_difference(*solver, reference), 1e-10);
+    failed |= check_below(
+        "async_output Ham error difference",
+        abs(solver->get_Ham_error() - reference.get_Ham_error()),
+        1e-8 * reference.get_Ham_error() + 1e-14);
+    delete solver;
+    return failed;
+}
+
+// A run restarted from a checkpoint half way should end on the same solution
+// and errors as the run that wrote the checkpoint
+int test_restart(GRParmParse &pp, const params_t &a_params)
+{
+    params_t params = a_params;
+    params.base_params.max_NL_iter = 4;
+    params.base_params.checkpoint_interval = 2;
+    params.base_params.checkpoint_prefix =
+        params.base_params.output_path + "SolverOptions_checkpoint_";
+    solver_t *full_run = run_solver(pp, params);
+
+    // the checkpoints the full run writes, at steps 2 and 4
+    std::vector<std::string> checkpoints;
+    for (int NL_iter = 2; NL_iter <= 4; NL_iter += 2)
+    {
+        char suffix[30];
+        sprintf(suffix, "%06d.%dd.hdf5", NL_iter, SpaceDim);
+        checkpoints.push_back(params.base_params.checkpoint_prefix + suffix);
+    }
+
+    params.base_params.restart = true;
+    params.base_params.restart_file = checkpoints[0];
+    params.base_params.checkpoint_interval = 0;
+    solver_t *restarted_run = run_solver(pp, params);
+
+    int failed = check_below("restart psi difference",
+                             psi_difference(*restarted_run, *full_run), 1e-10);
+    failed |= check_below(
+        "restart Ham error difference",
+        abs(restarted_run->get_Ham_error() - full_run->get_Ham_error()),
+        1e-8 * full_run->get_Ham_error() + 1e-12);
+    failed |= check_below(
+        "restart Mom error difference",
+        abs(restarted_run->get_Mom_error() - full_run->get_Mom_error()),
+        1e-8 * full_run->get_Mom_error() + 1e-12);
+    delete restarted_run;
+    delete full_run;
+
+    // both runs have closed the files by now
+    if (procID() == 0)
+    {
+        for (const std::string &checkpoint : checkpoints)
+        {
+            std::remove(checkpoint.c_str());
+        }
+    }
+    return failed;
+}
+#endif
+
+typedef int (*test_t)(GRParmParse &pp, const params_t &a_params);
+
+int main(int argc, char *argv[])
+{
+    int failed = 0;
+
+#ifdef CH_MPI
+    MPI_Init(&argc, &argv);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank == 0)
+        cout << "Running with MPI" << endl;
+#endif
+
+    if (argc < 2)
+    {
+        cerr << " usage " << argv[0] << " <input_file_name> [test names]"
+             << endl;
+        exit(0);
+    }
+
+    GRParmParse pp(0, argv + argc, NULL, argv[1]);
+    params_t params(pp);
+
+    const std::vector<std::pair<std::string, test_t>> tests = {
+        {"anderson_mixing", test_anderson_mixing},
+        {"deflate_zero_mode", test_deflate_zero_mode},
+        {"error_check_interval", test_error_check_interval},
+#ifdef CH_USE_HDF5
+        {"async_output", test_async_output},
+        {"restart", test_restart},
+#endif
+    };
+
+    // any arguments after the input file are the names of the tests to run
+    std::vector<std::string> names(argv + 2, argv + argc);
+    if (names.empty())
+    {
+        for (const auto &test : tests)
+        {
+            names.push_back(test.first);
+        }
+    }
+
+    for (const std::string &name : names)
+    {
+        auto test = tests.begin();
+        while (test != tests.end() && test->first != name)
+        {
+            ++test;
+        }
+        if (test == tests.end())
+        {
+            pout() << "There is no test called " << name << endl;
+            failed = -1;
+            continue;
+        }
+        int test_failed = test->second(pp, params);
+        pout() << name << (test_failed ? " failed" : " passed") << endl;
+        failed |= test_failed;
+    }
+
+    if (failed == 0)
+        std::cout << "SolverOptions test passed..." << std::endl;
+    else
+        std::cout << "SolverOptions test failed..." << std::endl;
+
+#ifdef CH_MPI
+    MPI_Finalize();
+#endif
+
+    return failed;
+}